@@ -0,0 +1,430 @@
+// Microbenchmarks and size sweeps for generation, solving, JSON and binary IO, raster
+// export and mesh building. Results are written as JSON (one entry per case) for regression
+// tracking:
+//   maze_bench [--out results.json] [--max 10000] [--min-time 0.2] [--filter text]
+#include "MazeGrid.h"
+#include "MazeGenerator.h"
+#include "MazeSolver.h"
+#include "MazeIO.h"
+#include "MazeMesh.h"
+#include "MazeRaster.h"
+#include "MazeFingerprint.h"
+#include "MazePathIndex.h"
+#include "MazeIncrementalSolver.h"
+
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Counts every heap allocation made by the process
+static std::atomic<uint64_t> gAllocations{0};
+static std::atomic<uint64_t> gAllocatedBytes{0};
+
+void* operator new(std::size_t n) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    gAllocatedBytes.fetch_add(n, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+long peakRssKb() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof pmc)) return 0;
+    return long(pmc.PeakWorkingSetSize / 1024);
+#else
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+#if defined(__APPLE__)
+    return long(ru.ru_maxrss / 1024); // bytes on macOS
+#else
+    return long(ru.ru_maxrss);        // kilobytes on Linux
+#endif
+#endif
+}
+
+struct Result {
+    std::string name;
+    int width = 0, height = 0;
+    int iterations = 0;
+    bool warm = false;
+    double nsPerOp = 0.0;
+    double allocationsPerOp = 0.0;
+    double bytesAllocatedPerOp = 0.0;
+    long peakRssKb = 0;
+    std::vector<std::pair<std::string, double>> counters; // case-specific extras
+};
+
+struct Runner {
+    double minSeconds = 0.2;
+    std::string filter;
+    std::vector<Result> results;
+
+    bool wanted(const std::string& name) const { return filter.empty() || name.find(filter) != std::string::npos; }
+
+    // Runs f until minSeconds have passed. Cases up to 1M cells get an untimed
+    // warm-up so reused buffers are sized; larger ones are measured cold, since
+    // a second pass would dominate the run time. Returns the recorded result
+    // (to attach counters), or null when the case is filtered out.
+    template <class F>
+    Result* run(const std::string& name, int w, int h, F&& f) {
+        if (!wanted(name)) return nullptr;
+        Result r;
+        r.name = name; r.width = w; r.height = h;
+        r.warm = uint64_t(w) * uint64_t(h) <= 1000000u;
+        if (r.warm) f();
+        const uint64_t allocs0 = gAllocations, bytes0 = gAllocatedBytes;
+        const auto t0 = Clock::now();
+        double elapsed = 0.0;
+        do {
+            f();
+            ++r.iterations;
+            elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+        } while (elapsed < minSeconds);
+        r.nsPerOp = elapsed * 1e9 / r.iterations;
+        r.allocationsPerOp = double(gAllocations - allocs0) / r.iterations;
+        r.bytesAllocatedPerOp = double(gAllocatedBytes - bytes0) / r.iterations;
+        r.peakRssKb = peakRssKb();
+        std::fprintf(stderr, "%-36s %6dx%-6d %12.0f ns/op %8.2f ns/cell %8.1f allocs/op\n",
+                     name.c_str(), w, h, r.nsPerOp, r.nsPerOp / (double(w) * h), r.allocationsPerOp);
+        results.push_back(r);
+        return &results.back();
+    }
+};
+
+const char* algorithmName(MazeAlgorithm a) {
+    switch (a) {
+        case MazeAlgorithm::Prims: return "Prims";
+        case MazeAlgorithm::Eller: return "Eller";
+        case MazeAlgorithm::Kruskal: return "Kruskal";
+        case MazeAlgorithm::RecursiveBacktracking: break;
+    }
+    return "RecursiveBacktracking";
+}
+
+bool writeJson(const std::vector<Result>& results, const std::string& path) {
+    std::ofstream f(path);
+    if (!f) return false;
+    f << "{\n  \"context\": {\"hardware_threads\": " << std::thread::hardware_concurrency() << "},\n";
+    f << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        const double cells = double(r.width) * r.height;
+        f << "    {\"name\": \"" << r.name << "\", \"width\": " << r.width << ", \"height\": " << r.height
+          << ", \"iterations\": " << r.iterations << ", \"warm\": " << (r.warm ? "true" : "false")
+          << ", \"ns_per_op\": " << r.nsPerOp << ", \"ns_per_cell\": " << r.nsPerOp / cells
+          << ", \"allocations_per_op\": " << r.allocationsPerOp
+          << ", \"bytes_allocated_per_op\": " << r.bytesAllocatedPerOp
+          << ", \"peak_rss_kb\": " << r.peakRssKb;
+        for (const auto& c : r.counters) f << ", \"" << c.first << "\": " << c.second;
+        f << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    f << "  ]\n}\n";
+    return bool(f);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string outPath = "maze_bench.json";
+    int maxSide = 10000;
+    Runner runner;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (a == "--out" && hasValue) outPath = argv[++i];
+        else if (a == "--max" && hasValue) maxSide = std::atoi(argv[++i]);
+        else if (a == "--min-time" && hasValue) runner.minSeconds = std::atof(argv[++i]);
+        else if (a == "--filter" && hasValue) runner.filter = argv[++i];
+        else {
+            std::cerr << "usage: maze_bench [--out file] [--max side] [--min-time seconds] [--filter text]" << std::endl;
+            return 2;
+        }
+    }
+
+    // JSON IO and the triangle-list mesh grow by tens to hundreds of bytes per
+    // cell, so their sweeps stop earlier than generation and solving.
+    const int sides[] = {20, 100, 1000, 3000, 10000};
+    const int maxIoSide = 1000;
+    const int maxMeshSide = 1000;
+    const int maxIncrementalSide = 3000; // 12 bytes of search state per cell
+    const MazeAlgorithm algs[] = {MazeAlgorithm::RecursiveBacktracking, MazeAlgorithm::Prims,
+                                  MazeAlgorithm::Eller, MazeAlgorithm::Kruskal};
+    const QString jsonPath = QString::fromStdString(
+        (std::filesystem::temp_directory_path() / "maze_bench_io.json").string());
+    const QString binPath = QString::fromStdString(
+        (std::filesystem::temp_directory_path() / "maze_bench_io.mzb").string());
+    const QString compactPath = QString::fromStdString(
+        (std::filesystem::temp_directory_path() / "maze_bench_io.mzc").string());
+    const QString tiledPath = QString::fromStdString(
+        (std::filesystem::temp_directory_path() / "maze_bench_io.mzt").string());
+    const QString pngPath = QString::fromStdString(
+        (std::filesystem::temp_directory_path() / "maze_bench_io.png").string());
+    // Save cases record the size of what they wrote, so formats compare on both axes
+    auto recordSize = [](Result* r, const QString& path) {
+        if (r) r->counters.push_back({"file_bytes", double(std::filesystem::file_size(path.toStdString()))});
+    };
+
+    for (int side : sides) {
+        if (side > maxSide) break;
+        MazeConfig cfg; cfg.width = side; cfg.height = side; cfg.seed = 12345;
+        MazeGrid grid(side, side);
+        MazeGenerator::Workspace ws;
+
+        for (MazeAlgorithm alg : algs) {
+            cfg.algorithm = alg;
+            runner.run(std::string("generate/") + algorithmName(alg), side, side,
+                       [&]() { MazeGenerator::generate(grid, cfg, ws); });
+        }
+        ws = MazeGenerator::Workspace();
+
+        // The remaining cases all work on one backtracker maze of this size
+        cfg.algorithm = MazeAlgorithm::RecursiveBacktracking;
+        MazeGenerator::generate(grid, cfg);
+
+        // Corner to corner, and to a goal a few cells away where the goal-directed
+        // solvers can stop early; explored counts the cells taken off a queue.
+        const struct { SolverAlgorithm alg; const char* name; } solvers[] = {
+            {SolverAlgorithm::BFS, "BFS"}, {SolverAlgorithm::AStar, "AStar"},
+            {SolverAlgorithm::BidirectionalBFS, "BidirectionalBFS"}};
+        const int near = std::min(side - 1, 8);
+        const struct { Coord goal; const char* suffix; } goals[] = {
+            {{side - 1, side - 1}, ""}, {{near, near}, "/near"}};
+        MazeSolver::Scratch scratch;
+        for (const auto& g : goals) {
+            for (const auto& sv : solvers) {
+                SolveStats stats;
+                Result* r = runner.run(std::string("solve/") + sv.name + g.suffix, side, side, [&]() {
+                    if (!MazeSolver::solve(sv.alg, grid, Coord{0, 0}, g.goal, scratch, &stats)) std::abort();
+                });
+                if (r) r->counters.push_back({"explored", double(stats.explored)});
+            }
+        }
+
+        // Tree index: one build, then many queries against the same maze
+        {
+            MazePathIndex index;
+            runner.run("pathIndex/build", side, side, [&]() { if (!index.build(grid)) std::abort(); });
+            if (!index.valid()) index.build(grid);
+            std::vector<Coord> pairs(2048);
+            uint64_t state = 88172645463325252ull;
+            for (Coord& c : pairs) {
+                state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+                c = Coord{int(state % uint64_t(side)), int((state >> 32) % uint64_t(side))};
+            }
+            uint64_t sink = 0;
+            const int queries = int(pairs.size() / 2);
+            Result* r = runner.run("pathIndex/distance", side, side, [&]() {
+                for (size_t i = 0; i < pairs.size(); i += 2) sink += index.distance(pairs[i], pairs[i + 1]);
+            });
+            if (r) r->counters.push_back({"queries_per_op", double(queries)});
+            std::vector<Coord> nodes;
+            r = runner.run("pathIndex/path", side, side, [&]() {
+                for (size_t i = 0; i < pairs.size(); i += 2) { index.path(pairs[i], pairs[i + 1], nodes); sink += nodes.size(); }
+            });
+            if (r) r->counters.push_back({"queries_per_op", double(queries)});
+            if (sink == 1) std::fprintf(stderr, " ");
+        }
+
+        // Incremental re-solve: each op opens a random door (a wall that is up),
+        // repairs the corner-to-corner path, closes it again and repairs once
+        // more; explored is the average cells re-expanded per repair
+        if (side <= maxIncrementalSide && side > 1) {
+            MazeGrid edited = grid;
+            MazeIncrementalSolver tracker;
+            tracker.reset(edited, Coord{0, 0}, Coord{side - 1, side - 1});
+            tracker.solve();
+            uint64_t state = 0x9E3779B97F4A7C15ull, explored = 0, repairs = 0;
+            Result* r = runner.run("solve/incremental", side, side, [&]() {
+                Coord a, b;
+                do {
+                    state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+                    const int x = int(state % uint64_t(side - 1)), y = int((state >> 32) % uint64_t(side - 1));
+                    a = Coord{x, y};
+                    b = (state >> 63) ? Coord{x + 1, y} : Coord{x, y + 1};
+                } while (b.x != a.x ? !edited.wallE(a.x, a.y) : !edited.wallS(a.x, a.y));
+                SolveStats stats;
+                edited.removeWallBetween(a, b);
+                tracker.wallChanged(a, b);
+                tracker.solve(&stats);
+                explored += stats.explored;
+                edited.addWallBetween(a, b);
+                tracker.wallChanged(a, b);
+                tracker.solve(&stats);
+                explored += stats.explored;
+                repairs += 2;
+            });
+            if (r) r->counters.push_back({"explored", double(explored) / double(repairs)});
+        }
+
+        std::vector<uint32_t> field(size_t(side) * size_t(side));
+        runner.run("solve/distanceField", side, side, [&]() {
+            MazeSolver::distanceField(grid, {Coord{0, 0}}, field.data(), 0);
+        });
+        field = std::vector<uint32_t>();
+
+        if (side <= maxIoSide) {
+            recordSize(runner.run("io/saveToJson", side, side, [&]() {
+                if (!MazeIO::saveToJson(grid, cfg, jsonPath)) std::abort();
+            }), jsonPath);
+            runner.run("io/loadCreate", side, side, [&]() {
+                std::unique_ptr<MazeGrid> loaded; MazeConfig loadedCfg;
+                if (!MazeIO::loadCreate(loaded, loadedCfg, jsonPath)) std::abort();
+            });
+            recordSize(runner.run("io/saveToJson/bitmask", side, side, [&]() {
+                if (!MazeIO::saveToJson(grid, cfg, jsonPath, MazeIO::JsonEncoding::Bitmask)) std::abort();
+            }), jsonPath);
+            runner.run("io/loadCreate/bitmask", side, side, [&]() {
+                std::unique_ptr<MazeGrid> loaded; MazeConfig loadedCfg;
+                if (!MazeIO::loadCreate(loaded, loadedCfg, jsonPath)) std::abort();
+            });
+        }
+
+        // The binary format is ~2 bits per cell, so it runs at every size. Mapping
+        // only validates the header and row padding.
+        recordSize(runner.run("io/saveBinary", side, side, [&]() {
+            if (!MazeIO::saveBinary(grid, cfg, binPath)) std::abort();
+        }), binPath);
+        runner.run("io/loadBinary", side, side, [&]() {
+            std::unique_ptr<MazeGrid> loaded; MazeConfig loadedCfg;
+            if (!MazeIO::loadBinary(loaded, loadedCfg, binPath)) std::abort();
+        });
+        runner.run("io/mapBinary", side, side, [&]() {
+            MazeIO::MappedMaze mapped;
+            if (!mapped.open(binPath)) std::abort();
+        });
+
+        // Compact files replay the seed (loading costs a generation), or without
+        // a seed arithmetic-code the walls
+        MazeConfig unseeded = cfg;
+        unseeded.seed = 0;
+        const struct { const MazeConfig* cfg; const char* suffix; } compactCases[] = {
+            {&cfg, ""}, {&unseeded, "/coded"}};
+        for (const auto& c : compactCases) {
+            recordSize(runner.run(std::string("io/saveCompact") + c.suffix, side, side, [&]() {
+                if (!MazeIO::saveCompact(grid, *c.cfg, compactPath)) std::abort();
+            }), compactPath);
+            runner.run(std::string("io/loadCompact") + c.suffix, side, side, [&]() {
+                std::unique_ptr<MazeGrid> loaded; MazeConfig loadedCfg;
+                if (!MazeIO::loadCompact(loaded, loadedCfg, compactPath)) std::abort();
+            });
+        }
+
+        // Tiled files: a 256x256 window in the middle only touches the tiles
+        // under it, so its cost stays flat as the maze grows
+        recordSize(runner.run("io/saveTiled", side, side, [&]() {
+            if (!MazeIO::saveTiled(grid, cfg, tiledPath)) std::abort();
+        }), tiledPath);
+        runner.run("io/loadCreate/tiled", side, side, [&]() {
+            std::unique_ptr<MazeGrid> loaded; MazeConfig loadedCfg;
+            if (!MazeIO::loadCreate(loaded, loadedCfg, tiledPath)) std::abort();
+        });
+        const MazeRect window{side / 2 - 128, side / 2 - 128, 256, 256};
+        runner.run("io/readRegion", side, side, [&]() {
+            std::unique_ptr<MazeGrid> loaded; MazeConfig loadedCfg;
+            if (!MazeIO::readRegion(tiledPath, window, loaded, loadedCfg)) std::abort();
+        });
+
+        // Fingerprints: one pass over the planes, and eight with the symmetries
+        {
+            uint64_t sink = 0;
+            MazeFingerprint::Scratch scratch;
+            runner.run("fingerprint/hash", side, side, [&]() { sink += MazeFingerprint::hash(grid); });
+            runner.run("fingerprint/canonical", side, side,
+                       [&]() { sink += MazeFingerprint::canonicalHash(grid, scratch); });
+            if (sink == 1) std::fprintf(stderr, " ");
+        }
+
+        // Raster export at 4 px per cell (16 Mpx at 1000x1000), walls only
+        if (side <= maxMeshSide) {
+            MazeRaster::Style style; style.cellPixels = 4; style.wallPixels = 1;
+            recordSize(runner.run("render/savePNG", side, side, [&]() {
+                if (!MazeRaster::savePNG(grid, {}, style, pngPath)) std::abort();
+            }), pngPath);
+        }
+
+        if (side <= maxMeshSide) {
+            MazeMesh::Mesh mesh;
+            Result* r = runner.run("mesh/buildMaze", side, side, [&]() { MazeMesh::buildMaze(grid, mesh); });
+            if (r) {
+                r->counters.push_back({"vertices", double(mesh.vertices.size())});
+                r->counters.push_back({"indices", double(mesh.indices.size())});
+                size_t walls = 0;
+                for (const MazeMesh::Chunk& c : mesh.chunks) walls += c.wallCount;
+                r->counters.push_back({"walls", double(walls)});
+                r->counters.push_back({"gpu_bytes", double(mesh.vertexBytes() + mesh.indexBytes() + mesh.wallBytes())});
+            }
+
+            // Frustum culling per frame: a first-person view from the middle of
+            // the west edge looking east (90 degree fov, far plane 500)
+            {
+                const float n = 0.1f, f = 500.0f, a = (f + n) / (n - f), b = 2 * f * n / (n - f), mid = side * 0.5f;
+                const float viewProj[16] = {0, 0, -a, 1,   0, 1, 0, 0,   1, 0, 0, 0,   -mid, -0.6f, b, 0};
+                MazeMesh::buildMaze(grid, mesh);
+                size_t drawn = 0;
+                Result* r = runner.run("mesh/cull", side, side, [&]() {
+                    const MazeMesh::Frustum frustum(viewProj);
+                    drawn = 0;
+                    for (const MazeMesh::Chunk& c : mesh.chunks) drawn += frustum.intersects(c);
+                });
+                if (r) r->counters.push_back({"drawn_fraction", double(drawn) / double(mesh.chunks.size())});
+            }
+
+            // Preview and edit updates: each op flips a random wall and
+            // rebuilds the chunks of the cells either side of it
+            if (side > 1) {
+                MazeGrid edited = grid;
+                MazeMesh::buildMaze(edited, mesh);
+                uint64_t state = 0x9E3779B97F4A7C15ull;
+                runner.run("mesh/updateWalls", side, side, [&]() {
+                    state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+                    const int x = int(state % uint64_t(side - 1)), y = int((state >> 32) % uint64_t(side - 1));
+                    const Coord a{x, y}, b = (state >> 63) ? Coord{x + 1, y} : Coord{x, y + 1};
+                    if (b.x != x ? edited.wallE(x, y) : edited.wallS(x, y)) edited.removeWallBetween(a, b);
+                    else edited.addWallBetween(a, b);
+                    MazeMesh::rebuildWalls(edited, mesh, MazeMesh::chunkAt(edited, a.x, a.y));
+                    MazeMesh::rebuildWalls(edited, mesh, MazeMesh::chunkAt(edited, b.x, b.y));
+                });
+            }
+        }
+    }
+    std::filesystem::remove(jsonPath.toStdString());
+    std::filesystem::remove(binPath.toStdString());
+    std::filesystem::remove(compactPath.toStdString());
+    std::filesystem::remove(tiledPath.toStdString());
+    std::filesystem::remove(pngPath.toStdString());
+
+    if (!writeJson(runner.results, outPath)) {
+        std::cerr << "Failed to write " << outPath << std::endl;
+        return 1;
+    }
+    std::cerr << "Wrote " << runner.results.size() << " results to " << outPath << std::endl;
+    return 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Union-find over 0..n-1 with path halving and union by rank, stored in a
+// single flat int32 array: entry i is i's parent, or -(rank+1) when i is a
+// root. A find therefore touches one array only. reset() reuses the storage.
+class DisjointSet {
+public:
+    DisjointSet() = default;
+    explicit DisjointSet(int32_t n) { reset(n); }
+
+    void reset(int32_t n) { parent_.assign(size_t(n), -1); }
+
+    int32_t size() const { return int32_t(parent_.size()); }
+
+    int32_t find(int32_t a) {
+        while (parent_[size_t(a)] >= 0) {
+            int32_t p = parent_[size_t(a)];
+            int32_t gp = parent_[size_t(p)];
+            if (gp < 0) return p;
+            parent_[size_t(a)] = gp;
+            a = gp;
+        }
+        return a;
+    }
+
+    // Merges the sets of a and b; returns false if they were already joined.
+    bool unite(int32_t a, int32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return false;
+        // Roots hold -(rank+1): the more negative one has the higher rank
+        if (parent_[size_t(a)] > parent_[size_t(b)]) std::swap(a, b);
+        if (parent_[size_t(a)] == parent_[size_t(b)]) --parent_[size_t(a)];
+        parent_[size_t(b)] = a;
+        return true;
+    }
+
+    // Hint that a will be looked up soon, so the cache misses of upcoming
+    // finds on large sets can overlap.
+    void prefetch(int32_t a) const {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(&parent_[size_t(a)]);
+#else
+        (void)a;
+#endif
+    }
+
+    // Second stage for a that was prefetch()ed earlier: its entry is cached
+    // by now, so fetch the parent it points at as well.
+    void prefetchParent(int32_t a) const {
+        const int32_t p = parent_[size_t(a)];
+        if (p >= 0) prefetch(p);
+    }
+
+private:
+    std::vector<int32_t> parent_;
+};
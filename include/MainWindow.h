@@ -9,6 +9,7 @@
 #include <QTimer>
 
 class MazeGLWidget;
+class MazeIOJob;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -21,6 +22,8 @@ private:
     void createToolbars();
     void createStatusBar();
     void createControlsPanel();
+    // Runs a save or load in the background; only one at a time
+    void startIoJob(MazeIOJob* job);
 
     MazeGLWidget* glWidget_;
     // Controls
@@ -33,10 +36,14 @@ private:
     QLabel* fpsLabel_ = nullptr;
     QLabel* progressLabel_ = nullptr;
     QTimer* previewTimer_ = nullptr;
+    QAction* cancelIoAct_ = nullptr;
+    MazeIOJob* ioJob_ = nullptr;
 
 private slots:
     void onGenerate();
     void onPreviewToggled(bool checked);
     void onPreviewStep();
     void onFpsUpdated(float fps);
+    void onIoProgress(qint64 bytes, qint64 totalBytes, qint64 cells, qint64 totalCells);
+    void onIoFinished(bool ok);
 };
@@ -0,0 +1,28 @@
+#pragma once
+#include "MazeGrid.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Compact encodings of a grid's walls, used by the .mzc format.
+namespace MazeCodec {
+    // Adaptive binary arithmetic coding of every wall bit. Each bit is predicted
+    // from neighbouring walls that are already coded (a perfect maze never
+    // closes a cell, corridors continue, ...), which brings mazes from 2 bits
+    // per cell down to roughly 1.3-1.8 where general-purpose compressors find
+    // almost nothing to remove.
+    std::vector<uint8_t> encodeWalls(const MazeGrid& grid);
+    // Decodes into `grid`, which must have the encoded size
+    bool decodeWalls(const uint8_t* data, size_t size, MazeGrid& grid);
+    // Fewest bytes encodeWalls() can produce for `cells` cells: the 5-byte
+    // flush, and at the most skewed probability a cell's two walls still cost
+    // about 1/180 of a byte. Shorter data cannot be a grid of that size.
+    uint64_t minEncodedSize(uint64_t cells);
+
+    // Positions where `grid` differs from `base` (same size), as a count and
+    // gaps between bit indices, all LEB128 varints. Bits index the horizontal
+    // then the vertical plane, rows padded as in MazeGrid.
+    std::vector<uint8_t> encodeDiff(const MazeGrid& base, const MazeGrid& grid);
+    // Flips the listed walls of `grid`
+    bool applyDiff(const uint8_t* data, size_t size, MazeGrid& grid);
+}
@@ -1,27 +1,97 @@
 #pragma once
 #include "MazeGrid.h"
 #include "MazeGenerator.h"
+#include "MazeSolver.h"
+#include "MazeSolveCache.h"
+#include "MazeIncrementalSolver.h"
+#include "MazeMesh.h"
 #include "MazeTypes.h"
 #include <memory>
+#include <algorithm>
 #include <vector>
 
 class MazeController {
 public:
     explicit MazeController(int w, int h) : grid_(std::make_unique<MazeGrid>(w,h)) {}
 
-    void regenerate(const MazeConfig& cfg) { MazeGenerator::generate(*grid_, cfg); previewActive_ = false; }
+    // Regenerates in place, reallocating the grid only if cfg's size differs
+    void regenerate(const MazeConfig& cfg) {
+        resize(cfg.width, cfg.height);
+        tracker_.detach();
+        MazeGenerator::generate(*grid_, cfg);
+        previewActive_ = false;
+        changedAll();
+    }
     const MazeGrid& grid() const { return *grid_; }
 
+    void resize(int w, int h) {
+        if (w != grid_->width() || h != grid_->height()) {
+            tracker_.detach();
+            grid_ = std::make_unique<MazeGrid>(w,h);
+            changedAll();
+        }
+    }
+
+    // Cells on either side of every wall changed since the last call, so a
+    // view can update just those. `all` is set instead when the whole grid
+    // changed: regenerating, resizing, starting a preview or applying a grid,
+    // or once more cells changed than there are mesh chunks to patch.
+    struct Changes {
+        bool all = false;
+        std::vector<Coord> cells;
+    };
+    // Copies into `out` so both lists keep their capacity across calls
+    void takeChanges(Changes& out) {
+        out.all = changes_.all;
+        out.cells.reserve(changes_.cells.capacity());
+        out.cells.assign(changes_.cells.begin(), changes_.cells.end());
+        changes_.all = false;
+        changes_.cells.clear();
+    }
+
+    // Solves on the current grid, answering repeated queries from the cache.
+    // Every mutation changes the grid's wall hash, so cached results never go
+    // stale. stats->explored is 0 for a cache hit.
+    std::optional<MazePath> solve(SolverAlgorithm alg, Coord start, Coord goal, SolveStats* stats = nullptr) {
+        const MazeSolveCache::Key key{grid_->wallHash(), start, goal, alg};
+        std::optional<MazePath> result;
+        if (solveCache_.lookup(key, result)) {
+            if (stats) *stats = SolveStats{};
+            return result;
+        }
+        result = MazeSolver::solve(alg, *grid_, start, goal, solverScratch_, stats);
+        solveCache_.store(key, result);
+        return result;
+    }
+    MazeSolveCache& solveCache() { return solveCache_; }
+    const MazeSolveCache& solveCache() const { return solveCache_; }
+
+    // Adds or removes the wall between adjacent cells a and b
+    void setWall(Coord a, Coord b, bool wall) {
+        if (wall) grid_->addWallBetween(a, b); else grid_->removeWallBetween(a, b);
+        tracker_.wallChanged(a, b);
+        changed(a, b);
+    }
+
+    // Like solve(), but the search state is kept: after setWall() or preview
+    // steps the path is repaired instead of recomputed. Regenerating, resizing
+    // or applying a grid starts the next call from scratch.
+    std::optional<MazePath> trackPath(Coord start, Coord goal, SolveStats* stats = nullptr) {
+        if (!tracker_.tracking(*grid_, start, goal)) tracker_.reset(*grid_, start, goal);
+        return tracker_.solve(stats);
+    }
+
     // Apply walls from an external grid of matching dimensions
     bool applyFromGrid(const MazeGrid& src) {
         if (src.width() != grid_->width() || src.height() != grid_->height()) return false;
-        for (int y=0; y<src.height(); ++y){
-            for (int x=0; x<src.width(); ++x){
-                const Cell &s = src.at(x,y);
-                Cell &d = grid_->at(x,y);
-                d.wallN = s.wallN; d.wallE = s.wallE; d.wallS = s.wallS; d.wallW = s.wallW; d.visited = true;
-            }
-        }
+        for (int r=0; r<=src.height(); ++r)
+            std::copy_n(src.hWallRow(r), src.hWordsPerRow(), grid_->hWallRow(r));
+        for (int y=0; y<src.height(); ++y)
+            std::copy_n(src.vWallRow(y), src.vWordsPerRow(), grid_->vWallRow(y));
+        grid_->markAllVisited();
+        tracker_.detach();
+        previewActive_ = false;
+        changedAll();
         return true;
     }
 
@@ -33,9 +103,26 @@ public:
 
 private:
     std::unique_ptr<MazeGrid> grid_;
+    MazeSolver::Scratch solverScratch_;
+    MazeSolveCache solveCache_;
+    MazeIncrementalSolver tracker_;
     MazeConfig cfg_{};
     bool previewActive_ = false;
     std::vector<Coord> stack_;
     int visitedCount_ = 0;
+    Changes changes_{true, {}};
     void initPreview();
+    size_t changeLimit() const {
+        return size_t(MazeMesh::chunksAlong(grid_->width())) * size_t(MazeMesh::chunksAlong(grid_->height()));
+    }
+    void changed(Coord a, Coord b) {
+        if (changes_.all) return;
+        if (changes_.cells.size() >= changeLimit()) { changedAll(); return; }
+        changes_.cells.push_back(a);
+        changes_.cells.push_back(b);
+    }
+    void changedAll() {
+        changes_.all = true;
+        changes_.cells.clear();
+    }
 };
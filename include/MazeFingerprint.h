@@ -0,0 +1,55 @@
+#pragma once
+#include "MazeGrid.h"
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+#include <vector>
+
+// Content hashes of a maze's walls, for finding duplicates in datasets.
+namespace MazeFingerprint {
+    // Hash of the dimensions and every wall bit, read a word at a time from the
+    // bitplanes. Independent of seed, config and visited flags, and stable
+    // across runs and hosts, so it can be stored.
+    uint64_t hash(const MazeGridView& grid);
+
+    // The eight rotations and reflections of the square, as bits applied in
+    // order: 4 transposes (swapping width and height), 1 mirrors left-right,
+    // 2 mirrors top-bottom. 0 is the identity; 5 and 6 are the quarter turns.
+    constexpr int kSymmetries = 8;
+    MazeGrid transformed(const MazeGridView& grid, int symmetry);
+
+    // Transformed bitplanes reused across calls
+    struct Scratch {
+        std::vector<uint64_t> h, v, th, tv;
+    };
+
+    // Smallest hash of the maze under the eight symmetries: mazes that are
+    // rotations or mirror images of each other get the same value
+    uint64_t canonicalHash(const MazeGridView& grid, Scratch& scratch);
+    uint64_t canonicalHash(const MazeGridView& grid);
+
+    // A maze within the scanned files: files[file], and for batch files (see
+    // MazeGenerator::generateBatch) its position in the batch
+    struct Entry {
+        int file = 0;
+        bool batch = false;
+        uint64_t index = 0;
+    };
+    // Mazes sharing a fingerprint, in file then batch order
+    struct Group {
+        uint64_t fingerprint = 0;
+        std::vector<Entry> members;
+    };
+    struct DedupResult {
+        std::vector<Group> groups;  // only fingerprints seen more than once, by first member
+        uint64_t mazes = 0;         // mazes hashed
+        std::vector<int> failed;    // files that could not be read
+    };
+
+    // Hashes every maze in `files` on `threads` workers (0 -> hardware
+    // concurrency) and groups the duplicates. Any format MazeIO::loadCreate
+    // reads is accepted, plus batch files, which are split into runs of
+    // records so one large batch still keeps every worker busy. With
+    // `canonical`, mazes equal up to rotation and reflection are duplicates.
+    DedupResult findDuplicates(const QStringList& files, bool canonical = false, int threads = 0);
+}
@@ -17,6 +17,7 @@
 #include "MazeController.h"
 #include "MazeTypes.h"
 #include "MazeSolver.h"
+#include "MazeMesh.h"
 
 class MazeGLWidget : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core {
     Q_OBJECT
@@ -29,6 +30,7 @@ public slots:
     void startPreview(const MazeConfig& cfg);
     void stepPreview();
     void runSolver();
+    void setSolverAlgorithm(SolverAlgorithm alg) { solver_ = alg; }
     void clearPath();
     void setStartGoal(Coord s, Coord g);
     void loadGridAndConfig(const MazeGrid& grid, const MazeConfig& cfg);
@@ -36,6 +38,23 @@ public slots:
     const MazeGrid& currentGrid() const { return controller_->grid(); }
     const MazeConfig& currentConfig() const { return cfg_; }
     QImage snapshot() { return grabFramebuffer(); }
+    const std::vector<Coord>& currentPath() const { return path_; }
+    const SolveStats& lastSolveStats() const { return solveStats_; }
+    const MazeSolveCache& solveCache() const { return controller_->solveCache(); }
+
+    // Size of the buffers last uploaded, the time spent on the last full
+    // build and upload or wall update, and the chunks the last frame drew and
+    // culled, for the status bar and profiling
+    struct GeometryStats {
+        size_t vertexBytes = 0;
+        size_t indexBytes = 0;
+        size_t wallBytes = 0;
+        double buildMs = 0.0;
+        double uploadMs = 0.0;
+        size_t chunksDrawn = 0;
+        size_t chunksCulled = 0;
+    };
+    const GeometryStats& geometryStats() const { return geometryStats_; }
 
     // Theme toggle
     void setThemeTextured(bool enabled);
@@ -96,12 +115,19 @@ private:
 
     // GL resources
     QOpenGLShaderProgram program_;
+    QOpenGLShaderProgram wallProgram_;
     GLuint vao_ = 0;
     GLuint vbo_ = 0;
+    GLuint ebo_ = 0;
+    GLuint wallVao_ = 0;
+    GLuint unitWallVbo_ = 0;
+    GLuint wallVbo_ = 0;
     GLuint wallTex_ = 0;
     GLuint floorTex_ = 0;
-    struct Vertex { QVector3D pos; QVector3D normal; QVector3D color; QVector2D uv; };
-    std::vector<Vertex> vertices_;
+    MazeMesh::Mesh mesh_;
+    std::vector<const MazeMesh::Chunk*> visibleChunks_; // this frame's, reused
+    std::vector<int> dirtyChunks_; // updateWalls' chunk list, reused
+    GeometryStats geometryStats_{};
 
     Sensitivity sens_{};
     QElapsedTimer frameTimer_;
@@ -109,17 +135,21 @@ private:
 
     // Maze and solver
     std::unique_ptr<MazeController> controller_;
+    MazeController::Changes changes_;
     MazeConfig cfg_;
     std::vector<Coord> path_;
+    SolverAlgorithm solver_ = SolverAlgorithm::BFS;
+    SolveStats solveStats_{};
     Coord start_{0,0};
     Coord goal_{0,0};
 
     // Geometry builders
     void buildMaze();
     void buildPathGeometry();
-    void addQuad(const QVector3D& a, const QVector3D& b, const QVector3D& c, const QVector3D& d, const QVector3D& normal, const QVector3D& color);
     void uploadGeometry();
+    void updateWalls(const std::vector<Coord>& cells);
     void createProceduralTextures();
+    void setCommonUniforms(QOpenGLShaderProgram& program, const QMatrix4x4& proj, const QMatrix4x4& view);
 
     QMatrix4x4 computeViewMatrix() const;
     QMatrix4x4 computeProjMatrix() const;
@@ -1,13 +1,108 @@
 #pragma once
 #include "MazeGrid.h"
 #include "MazeTypes.h"
+#include "DisjointSet.h"
 #include <random>
+#include <functional>
+#include <cstdint>
+#include <climits>
+#include <vector>
+#include <iosfwd>
 
 class MazeGenerator {
 public:
+    // Identifies the output of the kernels for a given config and seed. Bump it
+    // whenever a change to any algorithm, engine or the tiling alters the walls
+    // produced, so stored seeds from older versions are not replayed wrongly.
+    static constexpr uint32_t kVersion = 1;
+
+    // Scratch buffers reused across generate() calls. Once warmed up on a grid
+    // size, generating again into the same grid does not allocate (serial
+    // generation; the tiled path keeps one workspace per worker thread).
+    struct Workspace {
+        std::vector<uint8_t> stack;        // backtracker: direction of each step taken
+        std::vector<int32_t> frontier;     // Prim's: frontier cells (region-local indices)
+        std::vector<uint64_t> marks;       // Prim's: frontier membership bitset
+        std::vector<uint64_t> carved;      // Prim's: cells already in the maze
+        std::vector<uint32_t> edges;       // Kruskal's: walls in random order
+        std::vector<size_t> buckets, fill; // Kruskal's: shuffle buckets
+        DisjointSet sets;                  // Kruskal's and Eller's
+        std::vector<int> set, next, remaining;
+        std::vector<char> hasDown, used;
+        std::vector<uint64_t> vRow, sRow;  // Eller's: row being built
+    };
+
     static void generate(MazeGrid& grid, const MazeConfig& cfg);
+    static void generate(MazeGrid& grid, const MazeConfig& cfg, Workspace& ws);
+
+    // The seed generate() uses for cfg.seed: the seed itself, or a random
+    // nonzero one for 0. Resolve beforehand to know (and store) that seed.
+    static uint64_t resolveSeed(uint64_t seed);
+
+    // Prim's and Kruskal's number a region's cells and walls with 32-bit
+    // indices, so they never carve more cells than this at once
+    static constexpr int64_t kMaxIndexedRegionCells = INT32_MAX;
+
+    // The regions generate() carves for a w x h grid with `threads` workers
+    // (after resolving 0). A single region is the whole grid; otherwise the
+    // tiles are joined by seam openings. Grids too large for one Prim's or
+    // Kruskal's region are tiled even when serial.
+    static std::vector<MazeRect> planTiles(int w, int h, MazeAlgorithm alg, int threads);
+
+    // Receives one finished row y: its vertical walls (width+1 bits) and the walls
+    // on its south edge (width bits), in MazeGrid's row word layout. The buffers
+    // are reused for the next row.
+    using RowSink = std::function<void(int y, const uint64_t* vWalls, const uint64_t* southWalls)>;
+
+    // Row-streaming Eller generation: emits rows top to bottom without ever
+    // holding the full grid, using O(width) memory. cfg.algorithm is ignored.
+    static void generateRows(const MazeConfig& cfg, const RowSink& sink);
+
+    struct BatchStats {
+        uint64_t mazes = 0;
+        double seconds = 0.0;
+        double mazesPerSecond = 0.0;
+    };
+    // Receives each finished maze of a batch. Calls are serialized and arrive in
+    // seed order; the grid is only valid during the call.
+    using BatchSink = std::function<void(uint64_t seed, const MazeGrid& grid)>;
+
+    // Generates one maze per seed in [firstSeed, firstSeed+count) with cfg's size,
+    // algorithm and engine on `threads` workers (0 -> hardware concurrency). Each
+    // worker reuses one grid and workspace, and every maze is generated serially
+    // (cfg.threads is ignored), so it matches generate() with that seed. As in
+    // generate(), seed 0 means a random seed.
+    static BatchStats generateBatch(const MazeConfig& cfg, uint64_t firstSeed, uint64_t count,
+                                    const BatchSink& sink, int threads = 0);
+
+    // Same, streaming the batch to `out`: an "MZBATCH1" magic, then uint32 width,
+    // height, algorithm, rng and uint64 count, then per maze its uint64 seed
+    // followed by the horizontal and vertical bitplane words (little-endian hosts).
+    static BatchStats generateBatch(const MazeConfig& cfg, uint64_t firstSeed, uint64_t count,
+                                    std::ostream& out, int threads = 0);
 
 private:
-    static void genRecursiveBacktracking(MazeGrid& grid, std::mt19937_64& rng);
-    static void genPrims(MazeGrid& grid, std::mt19937_64& rng);
+    // Kernels are templated on the engine selected by MazeConfig::rng and only
+    // allocate through the workspace.
+    template <class Rng>
+    static void generateWith(MazeGrid& grid, const MazeConfig& cfg, uint64_t seed, Workspace& ws);
+
+    // Tiled parallel generation: each tile is carved on its own thread, then the
+    // tiles are joined by a random spanning tree of seam openings so the result
+    // is still a perfect maze. Deterministic for a given seed and thread count.
+    template <class Rng>
+    static void generateTiled(MazeGrid& grid, MazeAlgorithm alg, uint64_t seed, int threads);
+
+    template <class Rng>
+    static void carveRegion(MazeGrid& grid, const MazeRect& region, MazeAlgorithm alg, Rng& rng, Workspace& ws);
+    template <class Rng>
+    static void genRecursiveBacktracking(MazeGrid& grid, const MazeRect& region, Rng& rng, Workspace& ws);
+    template <class Rng>
+    static void genPrims(MazeGrid& grid, const MazeRect& region, Rng& rng, Workspace& ws);
+    template <class Rng>
+    static void genKruskal(MazeGrid& grid, const MazeRect& region, Rng& rng, Workspace& ws);
+    template <class Rng>
+    static void genEller(MazeGrid& grid, const MazeRect& region, Rng& rng, Workspace& ws);
+    template <class Rng, class Sink>
+    static void ellerRows(int width, int height, Rng& rng, Workspace& ws, Sink&& sink);
 };
@@ -1,48 +1,226 @@
 #pragma once
 #include "MazeTypes.h"
+#include "MazeRandom.h"
 #include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
 #include <stdexcept>
 
+// Compact maze storage. Every wall is stored exactly once:
+//  - horizontal bitplane: (height+1) rows of `width` bits; row r holds the walls on
+//    the edge above cell row r, so wallN(x,y) is bit x of row y and wallS(x,y) is
+//    bit x of row y+1.
+//  - vertical bitplane: `height` rows of (width+1) bits; bit x of row y is the wall
+//    on the west edge of cell x, so wallW(x,y) is bit x and wallE(x,y) is bit x+1.
+// Visited flags live in a separate bitset with the horizontal row layout.
+// Rows are padded to whole 64-bit words and padding bits are always zero, so the
+// word-level accessors can be used directly for scanning, hashing and IO.
 class MazeGrid {
 public:
-    MazeGrid(int w, int h) : width_(w), height_(h), cells_(w * h) {
+    // Proxy for a single bit, returned by the mutable at().
+    class BitRef {
+    public:
+        BitRef(uint64_t* word, uint64_t mask) : word_(word), mask_(mask) {}
+        operator bool() const { return (*word_ & mask_) != 0; }
+        BitRef& operator=(bool v) { if (v) *word_ |= mask_; else *word_ &= ~mask_; return *this; }
+        BitRef& operator=(const BitRef& o) { return *this = bool(o); }
+    private:
+        uint64_t* word_;
+        uint64_t mask_;
+    };
+
+    // Mutable view of a cell; reads and writes go straight to the bitplanes.
+    struct CellRef {
+        BitRef visited;
+        BitRef wallN;
+        BitRef wallE;
+        BitRef wallS;
+        BitRef wallW;
+        operator Cell() const { return Cell{visited, wallN, wallE, wallS, wallW}; }
+        CellRef& operator=(const Cell& c) {
+            visited = c.visited; wallN = c.wallN; wallE = c.wallE; wallS = c.wallS; wallW = c.wallW;
+            return *this;
+        }
+    };
+
+    MazeGrid(int w, int h) : width_(w), height_(h) {
         if (w <= 0 || h <= 0) throw std::invalid_argument("MazeGrid dimensions must be positive");
+        hStride_ = wordsForBits(size_t(w));
+        vStride_ = wordsForBits(size_t(w) + 1);
+        hWalls_.resize(hStride_ * size_t(h + 1));
+        vWalls_.resize(vStride_ * size_t(h));
+        visited_.resize(hStride_ * size_t(h));
+        resetAll();
     }
 
     int width() const { return width_; }
     int height() const { return height_; }
 
-    Cell& at(int x, int y) { return cells_[index(x,y)]; }
-    const Cell& at(int x, int y) const { return cells_[index(x,y)]; }
+    Cell at(int x, int y) const {
+        return Cell{visited(x,y), wallN(x,y), wallE(x,y), wallS(x,y), wallW(x,y)};
+    }
+    CellRef at(int x, int y) {
+        hashValid_ = false;
+        return CellRef{bitRef(visited_, visitedBit(x,y)),
+                       bitRef(hWalls_, hBit(x,y)), bitRef(vWalls_, vBit(x+1,y)),
+                       bitRef(hWalls_, hBit(x,y+1)), bitRef(vWalls_, vBit(x,y))};
+    }
 
     bool inBounds(int x, int y) const { return x >= 0 && y >= 0 && x < width_ && y < height_; }
 
-    void resetVisited() {
-        for (auto &c : cells_) c.visited = false;
+    // Per-edge queries
+    bool wallN(int x, int y) const { return testBit(hWalls_, hBit(x,y)); }
+    bool wallS(int x, int y) const { return testBit(hWalls_, hBit(x,y+1)); }
+    bool wallW(int x, int y) const { return testBit(vWalls_, vBit(x,y)); }
+    bool wallE(int x, int y) const { return testBit(vWalls_, vBit(x+1,y)); }
+
+    bool visited(int x, int y) const { return testBit(visited_, visitedBit(x,y)); }
+    void setVisited(int x, int y, bool v = true) { assignBit(visited_, visitedBit(x,y), v); }
+
+    void resetVisited() { std::fill(visited_.begin(), visited_.end(), 0); }
+    void markAllVisited() { fillPlane(visited_, hStride_, size_t(width_)); }
+
+    // All walls up (including the outer boundary), nothing visited.
+    void resetAll() {
+        hashValid_ = false;
+        fillPlane(hWalls_, hStride_, size_t(width_));
+        fillPlane(vWalls_, vStride_, size_t(width_) + 1);
+        resetVisited();
     }
 
     // Utility to remove wall between two adjacent cells
-    void removeWallBetween(const Coord& a, const Coord& b) {
+    void removeWallBetween(const Coord& a, const Coord& b) { setWallBetween(a, b, false); }
+    // Puts back the wall between two adjacent cells
+    void addWallBetween(const Coord& a, const Coord& b) { setWallBetween(a, b, true); }
+
+    // Hash of the dimensions and every wall bit (visited flags are not part of
+    // it). removeWallBetween and addWallBetween keep it current in O(1); other mutable access to
+    // the walls marks it stale and the next call rehashes the bitplanes. That
+    // rehash is cached in the grid, so this is not const and, like any other
+    // mutation, must not run concurrently with other access to the grid.
+    uint64_t wallHash() {
+        if (!hashValid_) {
+            uint64_t h = 0;
+            for (size_t i = 0; i < hWalls_.size(); ++i) h ^= wordKey(i, hWalls_[i]);
+            for (size_t i = 0; i < vWalls_.size(); ++i) h ^= wordKey(hWalls_.size() + i, vWalls_[i]);
+            wallHash_ = h;
+            hashValid_ = true;
+        }
+        return wallHash_ ^ splitmix64((uint64_t(uint32_t(width_)) << 32) | uint32_t(height_));
+    }
+
+    // Word-level access. Bit i of word k in a row covers column 64*k+i.
+    size_t hWordsPerRow() const { return hStride_; }
+    size_t vWordsPerRow() const { return vStride_; }
+    const uint64_t* hWallRow(int r) const { return hWalls_.data() + size_t(r) * hStride_; }
+    uint64_t* hWallRow(int r) { hashValid_ = false; return hWalls_.data() + size_t(r) * hStride_; }
+    const uint64_t* vWallRow(int y) const { return vWalls_.data() + size_t(y) * vStride_; }
+    uint64_t* vWallRow(int y) { hashValid_ = false; return vWalls_.data() + size_t(y) * vStride_; }
+    const uint64_t* visitedRow(int y) const { return visited_.data() + size_t(y) * hStride_; }
+    uint64_t* visitedRow(int y) { return visited_.data() + size_t(y) * hStride_; }
+
+    // Whole bitplanes, row-major with the strides above
+    const std::vector<uint64_t>& hWallWords() const { return hWalls_; }
+    const std::vector<uint64_t>& vWallWords() const { return vWalls_; }
+
+    static size_t wordsForBits(size_t bits) { return (bits + 63) / 64; }
+    // Mask of the valid bits in the last word of a row of `bits` bits
+    static uint64_t tailMask(size_t bits) { size_t r = bits % 64; return r ? ((uint64_t(1) << r) - 1) : ~uint64_t(0); }
+
+private:
+    size_t hBit(int x, int r) const { return size_t(r) * hStride_ * 64 + size_t(x); }
+    size_t vBit(int x, int y) const { return size_t(y) * vStride_ * 64 + size_t(x); }
+    size_t visitedBit(int x, int y) const { return size_t(y) * hStride_ * 64 + size_t(x); }
+
+    static bool testBit(const std::vector<uint64_t>& v, size_t i) { return (v[i >> 6] >> (i & 63)) & 1u; }
+    static void clearBit(std::vector<uint64_t>& v, size_t i) { v[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+    static void assignBit(std::vector<uint64_t>& v, size_t i, bool b) {
+        if (b) v[i >> 6] |= (uint64_t(1) << (i & 63)); else clearBit(v, i);
+    }
+    // Hash contribution of one bitplane word; planes are numbered as one sequence
+    static uint64_t wordKey(size_t i, uint64_t word) { return splitmix64(word ^ splitmix64(uint64_t(i))); }
+    void setWallBetween(const Coord& a, const Coord& b, bool wall) {
         int dx = b.x - a.x;
         int dy = b.y - a.y;
         if (dx == 1 && dy == 0) { // b is east
-            at(a.x,a.y).wallE = false;
-            at(b.x,b.y).wallW = false;
+            assignWall(vWalls_, vBit(b.x, a.y), wall);
         } else if (dx == -1 && dy == 0) { // b is west
-            at(a.x,a.y).wallW = false;
-            at(b.x,b.y).wallE = false;
+            assignWall(vWalls_, vBit(a.x, a.y), wall);
         } else if (dx == 0 && dy == 1) { // b is south
-            at(a.x,a.y).wallS = false;
-            at(b.x,b.y).wallN = false;
+            assignWall(hWalls_, hBit(a.x, b.y), wall);
         } else if (dx == 0 && dy == -1) { // b is north
-            at(a.x,a.y).wallN = false;
-            at(b.x,b.y).wallS = false;
+            assignWall(hWalls_, hBit(a.x, a.y), wall);
+        }
+    }
+    void assignWall(std::vector<uint64_t>& plane, size_t i, bool wall) {
+        const size_t w = i >> 6;
+        const uint64_t before = plane[w];
+        assignBit(plane, i, wall);
+        if (hashValid_) {
+            const size_t key = (&plane == &vWalls_ ? hWalls_.size() : 0) + w;
+            wallHash_ ^= wordKey(key, before) ^ wordKey(key, plane[w]);
+        }
+    }
+
+    static BitRef bitRef(std::vector<uint64_t>& v, size_t i) { return BitRef(&v[i >> 6], uint64_t(1) << (i & 63)); }
+
+    static void fillPlane(std::vector<uint64_t>& plane, size_t stride, size_t bits) {
+        const uint64_t tail = tailMask(bits);
+        for (size_t r = 0; r < plane.size(); r += stride) {
+            std::fill(plane.begin() + r, plane.begin() + r + stride, ~uint64_t(0));
+            plane[r + stride - 1] = tail;
         }
     }
 
-private:
-    int index(int x, int y) const { return y * width_ + x; }
     int width_;
     int height_;
-    std::vector<Cell> cells_;
+    size_t hStride_ = 0;
+    size_t vStride_ = 0;
+    std::vector<uint64_t> hWalls_;
+    std::vector<uint64_t> vWalls_;
+    std::vector<uint64_t> visited_;
+    uint64_t wallHash_ = 0;
+    bool hashValid_ = false;
+};
+
+// Read-only view of wall bitplanes laid out like MazeGrid's, which may live in
+// a MazeGrid or in external memory such as a mapped .mzb file. Solvers take a
+// view, so they run unchanged on either; the view does not own the planes.
+class MazeGridView {
+public:
+    MazeGridView() = default;
+    MazeGridView(const MazeGrid& grid)
+        : width_(grid.width()), height_(grid.height()),
+          hStride_(grid.hWordsPerRow()), vStride_(grid.vWordsPerRow()),
+          hWalls_(grid.hWallWords().data()), vWalls_(grid.vWallWords().data()) {}
+    // hPlane holds (h+1) rows and vPlane h rows, padded as in MazeGrid
+    MazeGridView(int w, int h, const uint64_t* hPlane, const uint64_t* vPlane)
+        : width_(w), height_(h),
+          hStride_(MazeGrid::wordsForBits(size_t(w))), vStride_(MazeGrid::wordsForBits(size_t(w) + 1)),
+          hWalls_(hPlane), vWalls_(vPlane) {}
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    bool inBounds(int x, int y) const { return x >= 0 && y >= 0 && x < width_ && y < height_; }
+
+    bool wallN(int x, int y) const { return testBit(hWalls_, size_t(y) * hStride_ * 64 + size_t(x)); }
+    bool wallS(int x, int y) const { return testBit(hWalls_, size_t(y + 1) * hStride_ * 64 + size_t(x)); }
+    bool wallW(int x, int y) const { return testBit(vWalls_, size_t(y) * vStride_ * 64 + size_t(x)); }
+    bool wallE(int x, int y) const { return testBit(vWalls_, size_t(y) * vStride_ * 64 + size_t(x) + 1); }
+
+    size_t hWordsPerRow() const { return hStride_; }
+    size_t vWordsPerRow() const { return vStride_; }
+    const uint64_t* hWallRow(int r) const { return hWalls_ + size_t(r) * hStride_; }
+    const uint64_t* vWallRow(int y) const { return vWalls_ + size_t(y) * vStride_; }
+
+private:
+    static bool testBit(const uint64_t* v, size_t i) { return (v[i >> 6] >> (i & 63)) & 1u; }
+
+    int width_ = 0;
+    int height_ = 0;
+    size_t hStride_ = 0;
+    size_t vStride_ = 0;
+    const uint64_t* hWalls_ = nullptr;
+    const uint64_t* vWalls_ = nullptr;
 };
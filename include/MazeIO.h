@@ -1,13 +1,120 @@
 #pragma once
 #include "MazeGrid.h"
 #include "MazeTypes.h"
+#include "MazeRaster.h"
 #include <QString>
-#include <QImage>
+#include <functional>
 #include <memory>
+#include <vector>
+
+class QFile;
+class QImage;
 
 namespace MazeIO {
-    bool saveToJson(const MazeGrid& grid, const MazeConfig& cfg, const QString& filePath);
+    // JSON cells are either objects of four named booleans or, more compactly,
+    // one integer per cell with bits N=1, E=2, S=4, W=8 ("cellMasks")
+    enum class JsonEncoding { Cells, Bitmask };
+
+    // Progress of a save or load, reported on the thread doing the work: file
+    // bytes and grid cells handled so far (totals are 0 while unknown). Returning
+    // false cancels; the call then fails and a save removes its partial file.
+    // JSON reports about every 64 KiB; the binary formats once the data is in.
+    struct Progress { qint64 bytes = 0, totalBytes = 0, cells = 0, totalCells = 0; };
+    using ProgressFn = std::function<bool(const Progress&)>;
+
+    // Both directions stream: the writer emits cells through a small buffer and
+    // the reader parses straight into the grid, in either encoding and with
+    // members in any order.
+    bool saveToJson(const MazeGrid& grid, const MazeConfig& cfg, const QString& filePath,
+                    JsonEncoding encoding = JsonEncoding::Cells, const ProgressFn& progress = {});
     bool loadFromJson(MazeGrid& grid, MazeConfig& cfg, const QString& filePath);
-    bool loadCreate(std::unique_ptr<MazeGrid>& outGrid, MazeConfig& outCfg, const QString& filePath);
+    bool loadJson(std::unique_ptr<MazeGrid>& outGrid, MazeConfig& outCfg, const QString& filePath,
+                  const ProgressFn& progress = {});
+    // Reads JSON, .mzb, .mzc or (all of) .mzt, recognised by content
+    bool loadCreate(std::unique_ptr<MazeGrid>& outGrid, MazeConfig& outCfg, const QString& filePath,
+                    const ProgressFn& progress = {});
+    // Writes .mzb, .mzc or .mzt by extension, JSON otherwise
+    bool save(const MazeGrid& grid, const MazeConfig& cfg, const QString& filePath,
+              const ProgressFn& progress = {});
+
+    // Binary .mzb (version 1): a 64-byte little-endian header (magic "MZBF",
+    // version, size, algorithm, rng, seed, threads and the byte offsets of the
+    // two planes) followed by both wall bitplanes exactly as MazeGrid stores
+    // them, as little-endian 64-bit words at 8-byte aligned offsets.
+    bool saveBinary(const MazeGrid& grid, const MazeConfig& cfg, const QString& filePath,
+                    const ProgressFn& progress = {});
+    bool loadBinary(std::unique_ptr<MazeGrid>& outGrid, MazeConfig& outCfg, const QString& filePath,
+                    const ProgressFn& progress = {});
+
+    // Compact .mzc (version 1): a 48-byte little-endian header (magic "MZCF",
+    // version, size, algorithm, rng, seed, threads, MazeGenerator::kVersion and
+    // the payload mode) and a payload. A maze with a fixed seed is stored as the
+    // list of walls that differ from regenerating it (usually none); otherwise,
+    // or when that list is larger, the walls are entropy coded (MazeCodec).
+    // Replaying needs the same generator version, so loading such a file from
+    // another version fails rather than producing a different maze.
+    bool saveCompact(const MazeGrid& grid, const MazeConfig& cfg, const QString& filePath,
+                     const ProgressFn& progress = {});
+    bool loadCompact(std::unique_ptr<MazeGrid>& outGrid, MazeConfig& outCfg, const QString& filePath,
+                     const ProgressFn& progress = {});
+
+    // Tiled .mzt (version 1): the maze cut into tileSize x tileSize tiles (edge
+    // tiles are smaller), each stored as a standalone grid with its own boundary
+    // walls, so a tile decodes without its neighbours. A 64-byte little-endian
+    // header (magic "MZTF", version, size, algorithm, rng, seed, threads, tile
+    // size, tile columns and rows, index offset) precedes a row-major index of
+    // 16 bytes per tile (u64 offset, u32 size, u32 encoding: 0 raw plane words,
+    // 1 MazeCodec::encodeWalls) and the tile payloads. Tiles are encoded and
+    // decoded on `threads` workers (0 -> hardware concurrency); progress comes
+    // once per row of tiles.
+    bool saveTiled(const MazeGrid& grid, const MazeConfig& cfg, const QString& filePath,
+                   int tileSize = 256, bool compress = true, int threads = 0, const ProgressFn& progress = {});
+    // Reads only the tiles overlapping `region` (clipped to the maze) and returns
+    // the walls of its cells in a grid of the clipped size. outCfg describes the
+    // whole maze in the file.
+    bool readRegion(const QString& filePath, const MazeRect& region, std::unique_ptr<MazeGrid>& outGrid,
+                    MazeConfig& outCfg, int threads = 0, const ProgressFn& progress = {});
+
+    // A .mzb file mapped read-only into memory; view() reads the walls straight
+    // from the mapping, so opening costs O(height) regardless of the maze size.
+    // Needs a little-endian host; elsewhere open() fails and loadBinary() still works.
+    class MappedMaze {
+    public:
+        MappedMaze();
+        ~MappedMaze();
+        MappedMaze(const MappedMaze&) = delete;
+        MappedMaze& operator=(const MappedMaze&) = delete;
+
+        bool open(const QString& filePath);
+        void close();
+        bool isOpen() const { return view_.width() > 0; }
+        const MazeGridView& view() const { return view_; }
+        const MazeConfig& config() const { return cfg_; }
+
+    private:
+        std::unique_ptr<QFile> file_;
+        MazeGridView view_;
+        MazeConfig cfg_{};
+    };
+
+    // Plain-text renderings of the walls: "+--+" ASCII art and an SVG of merged wall runs
+    bool saveAscii(const MazeGrid& grid, const QString& filePath);
+    bool saveSvg(const MazeGrid& grid, const QString& filePath, int cellSize = 10);
+
+    // The binary formats share their first 36 header bytes: magic, u32 version,
+    // u32 width, u32 height, u32 algorithm, u32 rng, u64 seed, i32 threads.
+    // Checks the magic, version and size and fills cfg; `d` must hold 36 bytes.
+    bool readHeaderConfig(const uchar* d, const char* magic, quint32 version, MazeConfig& cfg);
+
+    // Names used in files and on the command line; unknown names map to the defaults
+    QString algorithmName(MazeAlgorithm alg);
+    MazeAlgorithm algorithmFromName(const QString& name);
+    QString rngName(MazeRng rng);
+    MazeRng rngFromName(const QString& name);
+
+    // Defined in MazeIOImage.cpp, which needs Qt6::Gui and is only built into the GUI
     bool saveSnapshotPNG(const QImage& image, const QString& filePath);
+    // Top-down rendering of the whole maze as an indexed QImage (see MazeRaster)
+    QImage renderImage(const MazeGrid& grid, const std::vector<Coord>& path,
+                       const MazeRaster::Style& style = {}, int threads = 0);
 }
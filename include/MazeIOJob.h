@@ -0,0 +1,61 @@
+#pragma once
+#include "MazeGrid.h"
+#include "MazeIO.h"
+#include "MazeTypes.h"
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
+// A MazeIO save or load run on its own worker thread. Connect to the signals,
+// then start(); progress() and finished() are emitted from the worker, so
+// connections to objects on the GUI thread are queued. Collect the result
+// after finished(). Destroying a running job cancels it and waits for the worker.
+class MazeIOJob : public QObject {
+    Q_OBJECT
+public:
+    // Saves a snapshot of the grid, in the format MazeIO::save picks from the extension
+    static MazeIOJob* save(const MazeGrid& grid, const MazeConfig& cfg, const QString& filePath,
+                           QObject* parent = nullptr);
+    // Loads any format MazeIO::loadCreate reads
+    static MazeIOJob* load(const QString& filePath, QObject* parent = nullptr);
+    ~MazeIOJob() override;
+
+    void start();
+
+    bool isLoad() const { return load_; }
+    const QString& filePath() const { return path_; }
+
+    // Thread-safe. The operation stops at its next progress report and fails;
+    // a save removes its partial file.
+    void cancel() { canceled_ = true; }
+    bool isCanceled() const { return canceled_; }
+
+    // Blocks until the worker is done and returns its result
+    bool wait();
+
+    // Results of a load, valid once finished(true) has been emitted
+    std::unique_ptr<MazeGrid> takeGrid() { return std::move(grid_); }
+    const MazeConfig& config() const { return cfg_; }
+
+signals:
+    // At most every 50 ms, and once at the end
+    void progress(qint64 bytes, qint64 totalBytes, qint64 cells, qint64 totalCells);
+    void finished(bool ok);
+
+private:
+    using Work = std::function<bool(MazeIOJob&, const MazeIO::ProgressFn&)>;
+    MazeIOJob(bool load, const QString& filePath, Work work, QObject* parent);
+
+    const bool load_;
+    const QString path_;
+    Work work_;
+    std::atomic<bool> canceled_{false};
+    // Written by the worker before it emits finished()
+    bool ok_ = false;
+    std::unique_ptr<MazeGrid> grid_;
+    MazeConfig cfg_{};
+    std::thread worker_;
+};
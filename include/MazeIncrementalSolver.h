@@ -0,0 +1,66 @@
+#pragma once
+#include "MazeGrid.h"
+#include "MazeSolver.h"
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+// Shortest path between two fixed cells that is repaired, not recomputed,
+// when walls change (Lifelong Planning A*). Each cell keeps its current
+// distance estimate g and a one-step lookahead rhs = min(g(neighbor) + 1);
+// an edit only makes the two cells beside the changed wall inconsistent, and
+// the next solve() re-expands just the cells whose distances the edit can
+// affect on the way to the goal.
+//
+// The solver reads the grid it was reset on and does not own it: every wall
+// change must be reported through wallChanged() before the next solve(), and
+// bulk changes (regeneration, loading) need a reset().
+class MazeIncrementalSolver {
+public:
+    // Attaches to `grid` and clears all search state. O(cells); the first
+    // solve() afterwards is a full A* search.
+    void reset(const MazeGrid& grid, Coord start, Coord goal);
+    void detach() { grid_ = nullptr; }
+    bool tracking(const MazeGrid& grid, Coord start, Coord goal) const {
+        return grid_ == &grid && start.x == start_.x && start.y == start_.y &&
+               goal.x == goal_.x && goal.y == goal_.y;
+    }
+
+    // Call after the wall between adjacent cells a and b was added or removed
+    void wallChanged(Coord a, Coord b);
+
+    // Brings the search up to date and returns the path, or nullopt if the goal
+    // is unreachable. stats->explored counts cells expanded by this call only.
+    std::optional<MazePath> solve(SolveStats* stats = nullptr);
+    // Path length in steps after the last solve(), kUnreachable if none
+    uint32_t distance() const;
+
+private:
+    static constexpr uint32_t kInf = MazeSolver::kUnreachable;
+
+    uint32_t heuristic(int32_t i) const;
+    uint64_t key(int32_t i) const;
+    void updateCell(int32_t i);
+    void computeShortestPath(SolveStats* stats);
+
+    // Indexed binary min-heap of the inconsistent cells, ordered by key()
+    void heapPush(int32_t i, uint64_t k);
+    void heapRemove(int32_t i);
+    void heapUp(size_t pos);
+    void heapDown(size_t pos);
+
+    struct HeapEntry {
+        uint64_t key;
+        int32_t cell;
+    };
+
+    const MazeGrid* grid_ = nullptr;
+    Coord start_{0,0};
+    Coord goal_{0,0};
+    int32_t src_ = 0;
+    int32_t dst_ = 0;
+    std::vector<uint32_t> g_;
+    std::vector<uint32_t> rhs_;
+    std::vector<int32_t> heapPos_;          // -1 when the cell is not queued
+    std::vector<HeapEntry> heap_;
+};
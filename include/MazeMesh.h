@@ -0,0 +1,101 @@
+#pragma once
+#include "MazeGrid.h"
+#include "MazeTypes.h"
+#include <cstdint>
+#include <vector>
+
+// Packed vertex uploaded by the renderer as-is: attribute 0 is the position
+// (three unsigned shorts), 1 the normal ID and 2 the material ID (bytes, all
+// read as integers). The shader rebuilds normals, colours and UVs from them.
+struct MazeVertex {
+    uint16_t pos[3];   // relative to the chunk origin, in 1/MazeMesh::kPositionScale units
+    uint8_t normal;    // MazeMesh::Normal
+    uint8_t material;  // MazeMesh::Material
+};
+
+// One straight run of walls, drawn as an instance of MazeMesh::unitWall():
+// attribute 3, four bytes read as integers
+struct MazeWallInstance {
+    uint8_t x, z;    // start, in cells relative to the chunk origin
+    uint8_t length;  // cells
+    uint8_t axis;    // MazeMesh::Axis
+};
+
+// Indexed triangle mesh building without any GL or widget dependency, so the
+// renderer, the CLI and the benchmarks share one implementation. Triangles
+// wind counter-clockwise seen from the normal's side, for back-face culling.
+namespace MazeMesh {
+    enum Normal : uint8_t { PosX, NegX, PosY, NegY, PosZ, NegZ };
+    enum Material : uint8_t { Floor, Wall, PathMarker };
+    enum Axis : uint8_t { AlongX, AlongZ };
+
+    // Positions are quantized to hundredths of a cell: every size used below
+    // (wall height 1.8, path inset 0.15) is exact, and a chunk spans 3200
+    constexpr int kPositionScale = 100;
+    constexpr int kWallHeight = 180;
+    // Chunks are square blocks of cells, aligned so a chunk's row of wall bits
+    // sits inside one bitplane word (plus the east boundary bit at the edge)
+    constexpr int kChunkCells = 32;
+    static_assert(64 % kChunkCells == 0, "chunk rows must sit inside one bitplane word");
+    // Most wall runs a chunk can hold: every other cell along each of its
+    // kChunkCells + 1 grid lines in either direction
+    constexpr int kMaxChunkWalls = (kChunkCells + 1) * kChunkCells;
+    constexpr int chunksAlong(int cells) { return (cells + kChunkCells - 1) / kChunkCells; }
+
+    // A block of geometry drawn with one glDrawElementsBaseVertex and one
+    // glDrawArraysInstanced of its walls: its indices count from firstVertex,
+    // and its positions from (originX, originZ) cells. The maze's chunks have
+    // kMaxChunkWalls wall slots each, so one can be rebuilt in place.
+    struct Chunk {
+        int originX = 0, originZ = 0;
+        int cellsX = 0, cellsZ = 0; // extent, for the bounding box
+        uint32_t firstVertex = 0, vertexCount = 0;
+        uint32_t firstIndex = 0, indexCount = 0;
+        uint32_t firstWall = 0, wallCount = 0;
+    };
+
+    struct Mesh {
+        std::vector<MazeVertex> vertices;
+        std::vector<uint16_t> indices;
+        std::vector<MazeWallInstance> walls;
+        std::vector<Chunk> chunks;
+
+        void clear() { vertices.clear(); indices.clear(); walls.clear(); chunks.clear(); }
+        size_t vertexBytes() const { return vertices.size() * sizeof(MazeVertex); }
+        size_t indexBytes() const { return indices.size() * sizeof(uint16_t); }
+        size_t wallBytes() const { return walls.size() * sizeof(MazeWallInstance); }
+    };
+
+    // Both sides of a one-cell wall running along +x from the origin, as two
+    // triangles each. An instance stretches it along x by its length; AlongZ
+    // instances also turn it a quarter about +y (+x to -z), then move it onto
+    // the run from (x, z) to (x, z + length).
+    constexpr int kUnitWallVertices = 12;
+    const MazeVertex* unitWall();
+
+    // Replaces `out` with, per chunk, the floor quad and an instance for every
+    // straight run of walls along a grid line within the chunk. The chunks
+    // come first in `out.chunks`, row by row.
+    void buildMaze(const MazeGridView& grid, Mesh& out);
+    // Index of the chunk holding cell (x, y) with its north and west walls
+    int chunkAt(const MazeGridView& grid, int x, int y);
+    // Refills one chunk's wall instances from `grid` after its walls changed;
+    // the mesh must have been built from a grid of the same size
+    void rebuildWalls(const MazeGridView& grid, Mesh& mesh, int chunk);
+    // Appends a floor-level marker quad for each path cell, in chunks of their own.
+    void appendPath(const std::vector<Coord>& path, Mesh& out);
+
+    // The six clip planes of a view-projection matrix, for culling chunks
+    // before they are drawn
+    struct Frustum {
+        // Column-major, as QMatrix4x4::constData()
+        explicit Frustum(const float* viewProj);
+        // False only if the box is wholly outside one of the planes, so a box
+        // near a frustum corner can pass while out of view
+        bool intersects(const float lo[3], const float hi[3]) const;
+        // The chunk's bounding box, floor to wall top, against the frustum
+        bool intersects(const Chunk& chunk) const;
+
+        float planes[6][4]; // a, b, c, d with ax + by + cz + d >= 0 inside
+    };
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Runs f(i) for every i in [0, n) on up to `threads` workers (0 -> hardware
+// concurrency). Workers take indices in order, so items should be of similar
+// cost or listed largest first.
+template <class F>
+void parallelFor(size_t n, int threads, F&& f) {
+    const size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    const size_t workers = std::min(n, threads > 0 ? size_t(threads) : hw);
+    if (workers <= 1) {
+        for (size_t i = 0; i < n; ++i) f(i);
+        return;
+    }
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> pool;
+    pool.reserve(workers);
+    for (size_t t = 0; t < workers; ++t)
+        pool.emplace_back([&]() { for (size_t i; (i = next++) < n;) f(i); });
+    for (std::thread& th : pool) th.join();
+}
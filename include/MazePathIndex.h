@@ -0,0 +1,58 @@
+#pragma once
+#include "MazeGrid.h"
+#include "MazeSolver.h"
+#include <vector>
+#include <cstdint>
+
+// Route index for perfect mazes. The open passages of a perfect maze form a
+// spanning tree, so the index roots it once and then answers every query
+// without searching: distances in O(1) via the lowest common ancestor (Euler
+// tour + RMQ), paths in O(length) by walking parent links.
+//
+// The RMQ uses 32-entry blocks with a sparse table over the block minima and
+// per-position stack masks inside a block, which keeps the index linear in
+// size (about 28 bytes per cell) instead of O(n log n).
+class MazePathIndex {
+public:
+    MazePathIndex() = default;
+    explicit MazePathIndex(const MazeGridView& grid) { build(grid); }
+
+    // Indexes `grid`. Returns false (and leaves the index empty) if its passages
+    // are not a spanning tree, i.e. the maze has loops or unreachable cells.
+    bool build(const MazeGridView& grid);
+    bool valid() const { return width_ > 0; }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    // Steps from the root cell (0,0)
+    uint32_t depth(Coord c) const { return depth_[index(c)]; }
+    Coord lowestCommonAncestor(Coord a, Coord b) const { return coord(lca(index(a), index(b))); }
+    // Number of steps on the path from a to b
+    uint32_t distance(Coord a, Coord b) const;
+    // Cells from a to b inclusive; `out` is overwritten and its storage reused
+    void path(Coord a, Coord b, std::vector<Coord>& out) const;
+    MazePath path(Coord a, Coord b) const { MazePath p; path(a, b, p.nodes); return p; }
+
+private:
+    int32_t index(Coord c) const { return c.y * width_ + c.x; }
+    Coord coord(int32_t i) const { return Coord{i % width_, i / width_}; }
+    int32_t lca(int32_t a, int32_t b) const;
+    // Tour position of the shallowest node in tour[l..r]
+    uint32_t minPos(uint32_t l, uint32_t r) const;
+    uint32_t minInBlock(uint32_t l, uint32_t r) const;
+    uint32_t shallower(uint32_t p, uint32_t q) const {
+        return depth_[size_t(tour_[q])] < depth_[size_t(tour_[p])] ? q : p;
+    }
+
+    static constexpr uint32_t kBlock = 32;
+
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<int32_t> parent_;           // -1 at the root
+    std::vector<uint32_t> depth_;
+    std::vector<uint32_t> first_;           // first tour position of each cell
+    std::vector<int32_t> tour_;             // Euler tour, 2n-1 cells
+    std::vector<uint32_t> inBlock_;         // per tour position: stack of block minima so far
+    std::vector<std::vector<uint32_t>> blockTable_; // [k][b]: min position over blocks b..b+2^k-1
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <random>
+
+// Fast random engines for the generator kernels. Both model
+// UniformRandomBitGenerator and are seeded from a single 64-bit value, like
+// std::mt19937_64, so kernels can be instantiated on any of the three.
+
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// xoshiro256** (Blackman & Vigna)
+class Xoshiro256StarStar {
+public:
+    using result_type = uint64_t;
+    explicit Xoshiro256StarStar(uint64_t seed = 1) {
+        for (auto& w : s_) { seed += 0x9E3779B97F4A7C15ull; w = splitmix64(seed); }
+    }
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+    result_type operator()() {
+        const uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        const uint64_t t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+        return result;
+    }
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+    uint64_t s_[4];
+};
+
+// PCG64 (XSL-RR 128/64, O'Neill) with a portable 128-bit state
+class Pcg64 {
+public:
+    using result_type = uint64_t;
+    explicit Pcg64(uint64_t seed = 1, uint64_t stream = 0xDA3E39CB94B95BDBull) {
+        incHi_ = stream >> 63;
+        incLo_ = (stream << 1) | 1u;
+        step();
+        add(stateHi_, stateLo_, 0, seed);
+        step();
+    }
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+    result_type operator()() {
+        step();
+        const uint64_t x = stateHi_ ^ stateLo_;
+        const unsigned rot = unsigned(stateHi_ >> 58);
+        return (x >> rot) | (x << ((64 - rot) & 63));
+    }
+private:
+    static constexpr uint64_t kMulHi = 0x2360ED051FC65DA4ull;
+    static constexpr uint64_t kMulLo = 0x4385DF649FCCF645ull;
+
+    static uint64_t mulhi(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+        return uint64_t((unsigned __int128)a * b >> 64);
+#else
+        const uint64_t aL = a & 0xFFFFFFFFu, aH = a >> 32, bL = b & 0xFFFFFFFFu, bH = b >> 32;
+        const uint64_t ll = aL * bL, lh = aL * bH, hl = aH * bL, hh = aH * bH;
+        const uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFu) + (hl & 0xFFFFFFFFu);
+        return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+    }
+    static void add(uint64_t& hi, uint64_t& lo, uint64_t bHi, uint64_t bLo) {
+        lo += bLo;
+        hi += bHi + (lo < bLo ? 1u : 0u);
+    }
+    void step() {
+        // state = state * mult + inc (mod 2^128)
+        const uint64_t hi = mulhi(stateLo_, kMulLo) + stateLo_ * kMulHi + stateHi_ * kMulLo;
+        stateLo_ *= kMulLo;
+        stateHi_ = hi;
+        add(stateHi_, stateLo_, incHi_, incLo_);
+    }
+    uint64_t stateHi_ = 0, stateLo_ = 0;
+    uint64_t incHi_ = 0, incLo_ = 1;
+};
+
+// Unbiased integer in [0, n) (Lemire's multiply-shift with rejection)
+template <class Rng>
+uint64_t randomBelow(Rng& rng, uint64_t n) {
+    if (n > 0xFFFFFFFFull) return std::uniform_int_distribution<uint64_t>(0, n - 1)(rng);
+    const uint32_t bound = uint32_t(n);
+    uint64_t m = (uint64_t(rng()) >> 32) * bound;
+    if (uint32_t(m) < bound) {
+        const uint32_t threshold = uint32_t(-bound) % bound;
+        while (uint32_t(m) < threshold) m = (uint64_t(rng()) >> 32) * bound;
+    }
+    return m >> 32;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "MazeGrid.h"
+#include "MazeTypes.h"
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+// Top-down CPU rendering of a maze, independent of any GL context or window
+// size. Pixels are palette indices, one byte each.
+namespace MazeRaster {
+    enum PaletteIndex : uint8_t { Background = 0, Wall = 1, Path = 2 };
+
+    struct Style {
+        int cellPixels = 8;             // cell pitch; clamped to at least wallPixels + 1
+        int wallPixels = 2;             // wall thickness, at least 1
+        uint32_t background = 0xFFFFFF; // palette colours, 0xRRGGBB
+        uint32_t wall = 0x202020;
+        uint32_t path = 0xD03030;
+    };
+
+    // Every cell is cellPixels square with its north and west walls along its top
+    // and left edges; one extra wall strip closes the east and south sides.
+    int64_t imageWidth(const MazeGridView& grid, const Style& style);
+    int64_t imageHeight(const MazeGridView& grid, const Style& style);
+
+    // Cells of a path, sorted by row, for the renderers (empty: no path)
+    class PathCells {
+    public:
+        PathCells() = default;
+        PathCells(const std::vector<Coord>& path, int width);
+        bool empty() const { return keys_.empty(); }
+        // Marks the path cells of row y in `row` (width bytes, cleared first)
+        void markRow(int y, uint8_t* row) const;
+    private:
+        std::vector<uint64_t> keys_; // y * width + x
+        int width_ = 0;
+    };
+
+    // Renders image rows [y0, y1) into `out`, row y0 first, `stride` bytes apart.
+    // The buffer-based renderers need imageWidth() to fit in an int.
+    void renderRows(const MazeGridView& grid, const PathCells& path, const Style& style,
+                    int y0, int y1, uint8_t* out, size_t stride);
+    // Whole image, rows split across `threads` workers (0 -> hardware concurrency)
+    void render(const MazeGridView& grid, const PathCells& path, const Style& style,
+                uint8_t* out, size_t stride, int threads = 0);
+
+    // Streams the image to a palette PNG in strips of rows: the bands of each
+    // strip are rendered, filtered and deflated in parallel and then appended
+    // as IDAT chunks, so memory stays at one strip whatever the image size.
+    bool savePNG(const MazeGridView& grid, const PathCells& path, const Style& style,
+                 const QString& filePath, int threads = 0);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "MazeSolver.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <unordered_map>
+
+// LRU cache of solver results keyed by the grid's wall hash, its endpoints and
+// the solver. Any wall change alters the hash, so stale results are never
+// returned; they simply age out. "No path" results are cached too.
+class MazeSolveCache {
+public:
+    struct Key {
+        uint64_t wallHash = 0;
+        Coord start{0,0};
+        Coord goal{0,0};
+        SolverAlgorithm solver = SolverAlgorithm::BFS;
+        bool operator==(const Key& o) const {
+            return wallHash == o.wallHash && start.x == o.start.x && start.y == o.start.y &&
+                   goal.x == o.goal.x && goal.y == o.goal.y && solver == o.solver;
+        }
+    };
+
+    explicit MazeSolveCache(size_t byteBudget = size_t(8) << 20) : budget_(byteBudget) {}
+
+    // Copies a cached result into `out` and marks it most recently used
+    bool lookup(const Key& key, std::optional<MazePath>& out);
+    // Stores a result, evicting least recently used entries to stay within the
+    // budget. Results larger than the whole budget are not kept.
+    void store(const Key& key, const std::optional<MazePath>& result);
+    void clear();
+
+    void setBudget(size_t bytes);
+    size_t budget() const { return budget_; }
+    size_t bytes() const { return bytes_; }
+    size_t entries() const { return index_.size(); }
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+
+private:
+    struct Entry {
+        Key key;
+        std::optional<MazePath> result;
+        size_t bytes;
+    };
+    struct KeyHash {
+        size_t operator()(const Key& k) const;
+    };
+    void evictTo(size_t bytes);
+
+    size_t budget_;
+    size_t bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    std::list<Entry> lru_; // most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+};
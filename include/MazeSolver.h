@@ -2,12 +2,61 @@
 #include "MazeGrid.h"
 #include <vector>
 #include <optional>
+#include <cstdint>
 
 struct MazePath {
     std::vector<Coord> nodes; // sequence from start to goal
 };
 
+enum class SolverAlgorithm { BFS, AStar, BidirectionalBFS };
+
+struct SolveStats {
+    uint64_t explored = 0; // cells expanded (taken off a queue)
+};
+
 class MazeSolver {
 public:
-    static std::optional<MazePath> solveBFS(const MazeGrid& grid, Coord start, Coord goal);
+    // Buffers reused across solves. Visited marks are epoch stamps, so starting
+    // a new search is O(1) instead of clearing per-cell arrays.
+    struct Scratch {
+        std::vector<uint32_t> stamp;   // epoch in which the cell was reached
+        std::vector<int32_t> parent;   // predecessor cell index, -1 at the roots
+        std::vector<int32_t> dist;     // A* g and bidirectional depths
+        std::vector<int32_t> queue;    // flat BFS queue; bidirectional grows from both ends
+        std::vector<int32_t> open, next; // A* buckets for f and f+2
+        uint32_t epoch = 0;
+    };
+
+    static std::optional<MazePath> solveBFS(const MazeGridView& grid, Coord start, Coord goal);
+    static std::optional<MazePath> solveBFS(const MazeGridView& grid, Coord start, Coord goal,
+                                            Scratch& scratch, SolveStats* stats = nullptr);
+
+    // A* with the Manhattan heuristic. With unit steps f only grows by 0 or 2,
+    // so the open list is two LIFO buckets instead of a heap.
+    static std::optional<MazePath> solveAStar(const MazeGridView& grid, Coord start, Coord goal);
+    static std::optional<MazePath> solveAStar(const MazeGridView& grid, Coord start, Coord goal,
+                                              Scratch& scratch, SolveStats* stats = nullptr);
+
+    // BFS from both ends, always expanding a full level of the smaller frontier,
+    // until the two searches meet.
+    static std::optional<MazePath> solveBidirectionalBFS(const MazeGridView& grid, Coord start, Coord goal);
+    static std::optional<MazePath> solveBidirectionalBFS(const MazeGridView& grid, Coord start, Coord goal,
+                                                         Scratch& scratch, SolveStats* stats = nullptr);
+
+    static constexpr uint32_t kUnreachable = UINT32_MAX;
+
+    // Steps from the nearest source to every cell, written row-major to
+    // out[y*width + x] (kUnreachable where no source can reach). Level-synchronous:
+    // thin frontiers expand from a flat cell queue, wide ones sweep 64-cell bitset
+    // words row by row, split across `threads` workers (0 -> hardware
+    // concurrency) on very large grids. Only the wide levels use the workers,
+    // and perfect mazes never have any: their frontiers stay at a few thousand
+    // cells, too few to pay for a hand-off per level, so they run on the
+    // calling thread whatever `threads` says. Returns the largest finite
+    // distance, or kUnreachable if no source is inside the grid.
+    static uint32_t distanceField(const MazeGridView& grid, const std::vector<Coord>& sources,
+                                  uint32_t* out, int threads = 1);
+
+    static std::optional<MazePath> solve(SolverAlgorithm alg, const MazeGridView& grid, Coord start, Coord goal,
+                                         Scratch& scratch, SolveStats* stats = nullptr);
 };
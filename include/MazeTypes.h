@@ -6,7 +6,16 @@
 
 enum class MazeAlgorithm {
     RecursiveBacktracking,
-    Prims
+    Prims,
+    Eller,
+    Kruskal
+};
+
+// Random engine driving the generator kernels
+enum class MazeRng {
+    Mt19937_64,
+    Xoshiro256StarStar,
+    Pcg64
 };
 
 struct MazeConfig {
@@ -14,6 +23,8 @@ struct MazeConfig {
     int height = 20;  // rows
     uint64_t seed = 0; // 0 -> random_device
     MazeAlgorithm algorithm = MazeAlgorithm::RecursiveBacktracking;
+    int threads = 1;   // >1 -> tiled parallel generation, 0 -> hardware concurrency
+    MazeRng rng = MazeRng::Mt19937_64;
 };
 
 struct Cell {
@@ -26,3 +37,6 @@ struct Cell {
 };
 
 struct Coord { int x; int y; };
+
+// Axis-aligned block of cells: columns [x, x+width), rows [y, y+height)
+struct MazeRect { int x; int y; int width; int height; };
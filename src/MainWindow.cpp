@@ -2,6 +2,8 @@
 #include "MazeGLWidget.h"
 #include "MazeTypes.h"
 #include "MazeIO.h"
+#include "MazeIOJob.h"
+#include "MazeRaster.h"
 
 #include <QMenuBar>
 #include <QToolBar>
@@ -18,6 +20,7 @@
 #include <QGridLayout>
 #include <QLabel>
 #include <QFileDialog>
+#include <QKeySequence>
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent), glWidget_(new MazeGLWidget(this)) {
@@ -40,41 +43,35 @@ MainWindow::~MainWindow() = default;
 
 void MainWindow::createMenus() {
     auto* fileMenu = menuBar()->addMenu("&File");
-    auto* saveJsonAct = new QAction("Save JSON", this);
-    auto* loadJsonAct = new QAction("Load JSON", this);
+    auto* saveJsonAct = new QAction("Save Maze", this);
+    auto* loadJsonAct = new QAction("Load Maze", this);
     auto* exportPngAct = new QAction("Export PNG", this);
+    auto* exportImageAct = new QAction("Export Maze Image", this);
+    cancelIoAct_ = new QAction("Cancel Save/Load", this);
+    cancelIoAct_->setShortcut(QKeySequence::Cancel);
+    cancelIoAct_->setEnabled(false);
     fileMenu->addAction(saveJsonAct);
     fileMenu->addAction(loadJsonAct);
+    fileMenu->addAction(cancelIoAct_);
     fileMenu->addAction(exportPngAct);
+    fileMenu->addAction(exportImageAct);
 
     auto* exitAct = new QAction("E&xit", this);
     connect(exitAct, &QAction::triggered, this, &QWidget::close);
     fileMenu->addAction(exitAct);
 
     connect(saveJsonAct, &QAction::triggered, this, [this](){
-        QString fn = QFileDialog::getSaveFileName(this, "Save Maze JSON", QString(), "JSON Files (*.json)");
+        QString fn = QFileDialog::getSaveFileName(this, "Save Maze", QString(),
+                                                  "JSON Files (*.json);;Binary Maze Files (*.mzb);;Compact Maze Files (*.mzc)");
         if (fn.isEmpty()) return;
-        const auto &cfg = glWidget_->currentConfig();
-        const auto &grid = glWidget_->currentGrid();
-        if (MazeIO::saveToJson(grid, cfg, fn)) statusBar()->showMessage("Saved JSON", 2000);
-        else statusBar()->showMessage("Failed to save JSON", 2000);
+        startIoJob(MazeIOJob::save(glWidget_->currentGrid(), glWidget_->currentConfig(), fn, this));
     });
     connect(loadJsonAct, &QAction::triggered, this, [this](){
-        QString fn = QFileDialog::getOpenFileName(this, "Load Maze JSON", QString(), "JSON Files (*.json)");
+        QString fn = QFileDialog::getOpenFileName(this, "Load Maze", QString(), "Maze Files (*.json *.mzb *.mzc)");
         if (fn.isEmpty()) return;
-        std::unique_ptr<MazeGrid> g; MazeConfig cfg;
-        if (!MazeIO::loadCreate(g, cfg, fn)) {
-            QMessageBox::warning(this, "Load JSON", "Failed to parse JSON or invalid file.");
-            return;
-        }
-        widthSpin_->setValue(g->width());
-        heightSpin_->setValue(g->height());
-        int algIndex = (cfg.algorithm == MazeAlgorithm::Prims) ? 1 : 0;
-        algoCombo_->setCurrentIndex(algIndex);
-        seedEdit_->setText(QString::number(cfg.seed));
-        glWidget_->loadGridAndConfig(*g, cfg);
-        statusBar()->showMessage("Loaded JSON", 2000);
+        startIoJob(MazeIOJob::load(fn, this));
     });
+    connect(cancelIoAct_, &QAction::triggered, this, [this](){ if (ioJob_) ioJob_->cancel(); });
     connect(exportPngAct, &QAction::triggered, this, [this](){
         QString fn = QFileDialog::getSaveFileName(this, "Export PNG", QString(), "PNG Files (*.png)");
         if (fn.isEmpty()) return;
@@ -82,6 +79,14 @@ void MainWindow::createMenus() {
         if (MazeIO::saveSnapshotPNG(img, fn)) statusBar()->showMessage("Exported PNG", 2000);
         else statusBar()->showMessage("Failed to export PNG", 2000);
     });
+    connect(exportImageAct, &QAction::triggered, this, [this](){
+        // Full top-down plan of the maze and current path, whatever the window size
+        QString fn = QFileDialog::getSaveFileName(this, "Export Maze Image", QString(), "PNG Files (*.png)");
+        if (fn.isEmpty()) return;
+        const MazeRaster::PathCells path(glWidget_->currentPath(), glWidget_->currentGrid().width());
+        if (MazeRaster::savePNG(glWidget_->currentGrid(), path, {}, fn)) statusBar()->showMessage("Exported maze image", 2000);
+        else statusBar()->showMessage("Failed to export maze image", 2000);
+    });
 
     auto* helpMenu = menuBar()->addMenu("&Help");
     auto* aboutAct = new QAction("&About", this);
@@ -106,7 +111,12 @@ void MainWindow::createToolbars() {
 
     connect(genAct_, &QAction::triggered, this, &MainWindow::onGenerate);
     connect(previewAct_, &QAction::toggled, this, &MainWindow::onPreviewToggled);
-    connect(solveAct_, &QAction::triggered, this, [this](){ glWidget_->runSolver(); });
+    connect(solveAct_, &QAction::triggered, this, [this](){
+        glWidget_->runSolver();
+        const MazeSolveCache& cache = glWidget_->solveCache();
+        statusBar()->showMessage(QString("Solved, explored %1 cells (cache: %2 hits, %3 misses)")
+                                 .arg(glWidget_->lastSolveStats().explored).arg(cache.hits()).arg(cache.misses()), 2000);
+    });
     connect(clearPathAct, &QAction::triggered, this, [this](){ glWidget_->clearPath(); });
 }
 
@@ -126,13 +136,24 @@ void MainWindow::createControlsPanel(){
     algoCombo_ = new QComboBox(panel);
     algoCombo_->addItem("Recursive Backtracking", static_cast<int>(MazeAlgorithm::RecursiveBacktracking));
     algoCombo_->addItem("Prim's", static_cast<int>(MazeAlgorithm::Prims));
+    algoCombo_->addItem("Eller's", static_cast<int>(MazeAlgorithm::Eller));
+    algoCombo_->addItem("Kruskal's", static_cast<int>(MazeAlgorithm::Kruskal));
 
     widthSpin_ = new QSpinBox(panel); widthSpin_->setRange(5, 200); widthSpin_->setValue(20);
     heightSpin_ = new QSpinBox(panel); heightSpin_->setRange(5, 200); heightSpin_->setValue(20);
     seedEdit_ = new QLineEdit(panel); seedEdit_->setPlaceholderText("0 = random"); seedEdit_->setText("0");
 
+    auto* solverCombo = new QComboBox(panel);
+    solverCombo->addItem("BFS", static_cast<int>(SolverAlgorithm::BFS));
+    solverCombo->addItem("A*", static_cast<int>(SolverAlgorithm::AStar));
+    solverCombo->addItem("Bidirectional BFS", static_cast<int>(SolverAlgorithm::BidirectionalBFS));
+    QObject::connect(solverCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), [this, solverCombo](int){
+        glWidget_->setSolverAlgorithm(static_cast<SolverAlgorithm>(solverCombo->currentData().toInt()));
+    });
+
     int r=0;
     layout->addWidget(new QLabel("Algorithm:"), r,0); layout->addWidget(algoCombo_, r,1); r++;
+    layout->addWidget(new QLabel("Solver:"), r,0); layout->addWidget(solverCombo, r,1); r++;
     auto* themeCombo_ = new QComboBox(panel); themeCombo_->addItem("Flat"); themeCombo_->addItem("Textured");
     layout->addWidget(new QLabel("Theme:"), r,0); layout->addWidget(themeCombo_, r,1); r++;
     QObject::connect(themeCombo_, &QComboBox::currentTextChanged, [this](const QString& t){ glWidget_->setThemeTextured(t=="Textured"); });
@@ -173,10 +194,71 @@ void MainWindow::onPreviewToggled(bool checked){
     }
 }
 
+void MainWindow::startIoJob(MazeIOJob* job){
+    if (ioJob_) {
+        // The dialogs are modal, so this only happens via queued triggers; keep the running job
+        delete job;
+        statusBar()->showMessage("A save or load is already running", 2000);
+        return;
+    }
+    ioJob_ = job;
+    cancelIoAct_->setEnabled(true);
+    connect(job, &MazeIOJob::progress, this, &MainWindow::onIoProgress);
+    connect(job, &MazeIOJob::finished, this, &MainWindow::onIoFinished);
+    job->start();
+    statusBar()->showMessage(job->isLoad() ? "Loading maze..." : "Saving maze...");
+}
+
+void MainWindow::onIoProgress(qint64 bytes, qint64 totalBytes, qint64 cells, qint64 totalCells){
+    if (!ioJob_) return;
+    QString text = QString(ioJob_->isLoad() ? "Loading maze: %1 MB" : "Saving maze: %1 MB").arg(bytes / 1048576.0, 0, 'f', 1);
+    if (totalBytes > 0) text += QString(" of %1 MB").arg(totalBytes / 1048576.0, 0, 'f', 1);
+    text += QString(", %1").arg(cells);
+    if (totalCells > 0) text += QString(" of %1").arg(totalCells);
+    text += " cells (Esc to cancel)";
+    statusBar()->showMessage(text);
+}
+
+void MainWindow::onIoFinished(bool ok){
+    MazeIOJob* job = ioJob_;
+    if (!job) return;
+    ioJob_ = nullptr;
+    cancelIoAct_->setEnabled(false);
+    job->deleteLater(); // joins the worker, which has nothing left to do
+    if (job->isCanceled()) {
+        statusBar()->showMessage(job->isLoad() ? "Load canceled" : "Save canceled", 2000);
+        return;
+    }
+    if (!job->isLoad()) {
+        statusBar()->showMessage(ok ? "Saved maze" : "Failed to save maze", 2000);
+        return;
+    }
+    if (!ok) {
+        statusBar()->clearMessage();
+        QMessageBox::warning(this, "Load Maze", "Failed to parse the file or invalid maze.");
+        return;
+    }
+    std::unique_ptr<MazeGrid> g = job->takeGrid();
+    const MazeConfig& cfg = job->config();
+    widthSpin_->setValue(g->width());
+    heightSpin_->setValue(g->height());
+    int algIndex = algoCombo_->findData(static_cast<int>(cfg.algorithm));
+    algoCombo_->setCurrentIndex(algIndex < 0 ? 0 : algIndex);
+    seedEdit_->setText(QString::number(cfg.seed));
+    glWidget_->loadGridAndConfig(*g, cfg);
+    statusBar()->showMessage("Loaded maze", 2000);
+}
+
 void MainWindow::onPreviewStep(){
     glWidget_->stepPreview();
 }
 
 void MainWindow::onFpsUpdated(float fps){
-    fpsLabel_->setText(QString("FPS: %1").arg(QString::number(fps, 'f', 1)));
+    const MazeGLWidget::GeometryStats& g = glWidget_->geometryStats();
+    fpsLabel_->setText(QString("FPS: %1 | Mesh: %2 KiB, upload %3 ms | Chunks: %4 drawn, %5 culled")
+                           .arg(QString::number(fps, 'f', 1))
+                           .arg((g.vertexBytes + g.indexBytes + g.wallBytes) / 1024)
+                           .arg(QString::number(g.uploadMs, 'f', 2))
+                           .arg(g.chunksDrawn)
+                           .arg(g.chunksCulled));
 }
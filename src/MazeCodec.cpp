@@ -0,0 +1,204 @@
+#include "MazeCodec.h"
+#include "MazeBits.h"
+
+namespace {
+
+// LZMA-style range coder: 11-bit probabilities adapted with shift 5
+constexpr uint32_t kProbBits = 11;
+constexpr uint16_t kProbInit = 1u << (kProbBits - 1);
+constexpr int kMoveBits = 5;
+constexpr uint32_t kTop = 1u << 24;
+
+class Encoder {
+public:
+    unsigned code(uint16_t& p, const uint64_t* plane, size_t i) {
+        const unsigned bit = unsigned(plane[i >> 6] >> (i & 63)) & 1u;
+        const uint32_t bound = (range_ >> kProbBits) * p;
+        if (bit == 0) {
+            range_ = bound;
+            p = uint16_t(p + (((1u << kProbBits) - p) >> kMoveBits));
+        } else {
+            low_ += bound;
+            range_ -= bound;
+            p = uint16_t(p - (p >> kMoveBits));
+        }
+        while (range_ < kTop) { range_ <<= 8; shiftLow(); }
+        return bit;
+    }
+    std::vector<uint8_t> finish() {
+        for (int i = 0; i < 5; ++i) shiftLow();
+        return std::move(out_);
+    }
+
+private:
+    void shiftLow() {
+        if (uint32_t(low_) < 0xFF000000u || (low_ >> 32) != 0) {
+            const uint8_t carry = uint8_t(low_ >> 32);
+            uint8_t temp = cache_;
+            do {
+                out_.push_back(uint8_t(temp + carry));
+                temp = 0xFF;
+            } while (--cacheSize_ != 0);
+            cache_ = uint8_t(low_ >> 24);
+        }
+        ++cacheSize_;
+        low_ = (low_ & 0x00FFFFFFu) << 8;
+    }
+
+    uint64_t low_ = 0;
+    uint32_t range_ = 0xFFFFFFFFu;
+    uint8_t cache_ = 0;
+    uint64_t cacheSize_ = 1;
+    std::vector<uint8_t> out_;
+};
+
+class Decoder {
+public:
+    Decoder(const uint8_t* data, size_t size) : data_(data), size_(size) {
+        for (int i = 0; i < 5; ++i) code_ = (code_ << 8) | next();
+    }
+    unsigned code(uint16_t& p, uint64_t* plane, size_t i) {
+        const uint32_t bound = (range_ >> kProbBits) * p;
+        unsigned bit;
+        if (code_ < bound) {
+            range_ = bound;
+            p = uint16_t(p + (((1u << kProbBits) - p) >> kMoveBits));
+            bit = 0;
+        } else {
+            code_ -= bound;
+            range_ -= bound;
+            p = uint16_t(p - (p >> kMoveBits));
+            bit = 1;
+        }
+        while (range_ < kTop) { range_ <<= 8; code_ = (code_ << 8) | next(); }
+        const uint64_t mask = uint64_t(1) << (i & 63);
+        if (bit) plane[i >> 6] |= mask; else plane[i >> 6] &= ~mask;
+        return bit;
+    }
+    // The encoder's flush leaves the decoder exactly at the end of the data
+    bool ok() const { return pos_ <= size_; }
+
+private:
+    uint32_t next() { return pos_ < size_ ? data_[pos_++] : (++pos_, 0u); }
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+    uint32_t range_ = 0xFFFFFFFFu;
+    uint32_t code_ = 0;
+};
+
+// Visits every wall bit in a fixed order, row by row: the top boundary, then per
+// row the west boundary and each cell's east and south walls. Contexts only use
+// bits visited earlier, so the encoder (reading) and decoder (writing) share
+// this walk. Word is const uint64_t for encoding and uint64_t for decoding.
+template <class Coder, class Word>
+void walkWalls(Coder& c, Word* h, Word* v, size_t hs, size_t vs, int W, int H) {
+    uint16_t interiorE[32], interiorS[32], boundary[4];
+    for (uint16_t& p : interiorE) p = kProbInit;
+    for (uint16_t& p : interiorS) p = kProbInit;
+    for (uint16_t& p : boundary) p = kProbInit;
+    auto hBit = [&](int x, int r) { return unsigned(h[size_t(r) * hs + size_t(x) / 64] >> (x & 63)) & 1u; };
+    auto vBit = [&](int x, int y) { return unsigned(v[size_t(y) * vs + size_t(x) / 64] >> (x & 63)) & 1u; };
+
+    for (int x = 0; x < W; ++x) c.code(boundary[0], h, size_t(x));
+    for (int y = 0; y < H; ++y) {
+        const size_t hRow = size_t(y + 1) * hs * 64, vRow = size_t(y) * vs * 64;
+        c.code(boundary[1], v, vRow);
+        for (int x = 0; x < W; ++x) {
+            const unsigned n = hBit(x, y), w = vBit(x, y);
+            const unsigned up = y > 0 ? vBit(x + 1, y - 1) : 1u;  // east wall of the cell above
+            const unsigned nr = x + 1 < W ? hBit(x + 1, y) : 1u;  // north wall of the cell to the east
+            const unsigned sl = x > 0 ? hBit(x - 1, y + 1) : 1u;  // south wall of the cell to the west
+            const unsigned e = x + 1 < W ? c.code(interiorE[n | w << 1 | up << 2 | nr << 3 | sl << 4], v, vRow + size_t(x) + 1)
+                                         : c.code(boundary[2], v, vRow + size_t(x) + 1);
+            if (y + 1 < H) c.code(interiorS[n | w << 1 | e << 2 | sl << 3 | nr << 4], h, hRow + size_t(x));
+            else c.code(boundary[3], h, hRow + size_t(x));
+        }
+    }
+}
+
+void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) { out.push_back(uint8_t(v | 0x80)); v >>= 7; }
+    out.push_back(uint8_t(v));
+}
+
+bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        const uint8_t b = *p++;
+        v |= uint64_t(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+}
+
+namespace MazeCodec {
+
+std::vector<uint8_t> encodeWalls(const MazeGrid& grid) {
+    Encoder enc;
+    walkWalls(enc, grid.hWallRow(0), grid.vWallRow(0), grid.hWordsPerRow(), grid.vWordsPerRow(),
+              grid.width(), grid.height());
+    return enc.finish();
+}
+
+bool decodeWalls(const uint8_t* data, size_t size, MazeGrid& grid) {
+    Decoder dec(data, size);
+    walkWalls(dec, grid.hWallRow(0), grid.vWallRow(0), grid.hWordsPerRow(), grid.vWordsPerRow(),
+              grid.width(), grid.height());
+    return dec.ok();
+}
+
+uint64_t minEncodedSize(uint64_t cells) {
+    return 5 + cells / 256;
+}
+
+std::vector<uint8_t> encodeDiff(const MazeGrid& base, const MazeGrid& grid) {
+    const std::vector<uint64_t>* planes[2][2] = {{&base.hWallWords(), &grid.hWallWords()},
+                                                 {&base.vWallWords(), &grid.vWallWords()}};
+    std::vector<uint64_t> positions;
+    uint64_t offset = 0;
+    for (auto& pair : planes) {
+        const std::vector<uint64_t>& a = *pair[0];
+        const std::vector<uint64_t>& b = *pair[1];
+        for (size_t k = 0; k < a.size(); ++k)
+            for (uint64_t d = a[k] ^ b[k]; d; d &= d - 1)
+                positions.push_back(offset + k * 64 + uint64_t(lowestBit(d)));
+        offset += uint64_t(a.size()) * 64;
+    }
+    std::vector<uint8_t> out;
+    putVarint(out, positions.size());
+    uint64_t prev = 0;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        putVarint(out, i ? positions[i] - prev - 1 : positions[i]);
+        prev = positions[i];
+    }
+    return out;
+}
+
+bool applyDiff(const uint8_t* data, size_t size, MazeGrid& grid) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    const uint64_t hRowBits = uint64_t(grid.hWordsPerRow()) * 64, vRowBits = uint64_t(grid.vWordsPerRow()) * 64;
+    const uint64_t hBits = uint64_t(grid.hWallWords().size()) * 64;
+    const uint64_t total = hBits + uint64_t(grid.vWallWords().size()) * 64;
+    uint64_t count = 0, pos = 0, gap = 0;
+    if (!getVarint(p, end, count) || count > total) return false;
+    uint64_t* h = grid.hWallRow(0);
+    uint64_t* v = grid.vWallRow(0);
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!getVarint(p, end, gap)) return false;
+        pos = i ? pos + gap + 1 : gap;
+        if (pos >= total || pos < gap) return false;
+        // Row padding must stay clear
+        const uint64_t col = pos < hBits ? pos % hRowBits : (pos - hBits) % vRowBits;
+        if (col >= uint64_t(grid.width()) + (pos < hBits ? 0 : 1)) return false;
+        uint64_t* word = pos < hBits ? h + pos / 64 : v + (pos - hBits) / 64;
+        *word ^= uint64_t(1) << (pos & 63);
+    }
+    return p == end;
+}
+
+}
@@ -2,32 +2,34 @@
 #include <algorithm>
 #include <random>
 
-static std::vector<Coord> neighbors4(const MazeGrid& grid, const Coord& c) {
+// Fills `out` with the in-bounds neighbors of c; returns how many there are
+static int neighbors4(const MazeGrid& grid, const Coord& c, Coord (&out)[4]) {
     static const int dx[4] = {0, 1, 0, -1};
     static const int dy[4] = {-1, 0, 1, 0};
-    std::vector<Coord> res;
+    int count = 0;
     for (int i = 0; i < 4; ++i) {
         int nx = c.x + dx[i];
         int ny = c.y + dy[i];
-        if (grid.inBounds(nx, ny)) res.push_back({nx, ny});
+        if (grid.inBounds(nx, ny)) out[count++] = {nx, ny};
     }
-    return res;
+    return count;
 }
 
 void MazeController::startPreview(const MazeConfig& cfg) {
     cfg_ = cfg;
+    resize(cfg.width, cfg.height);
     previewActive_ = true;
     initPreview();
 }
 
 void MazeController::initPreview() {
-    for (int y = 0; y < grid_->height(); ++y) for (int x = 0; x < grid_->width(); ++x) {
-        auto &cell = grid_->at(x,y);
-        cell.visited = false;
-        cell.wallN = cell.wallE = cell.wallS = cell.wallW = true;
-    }
+    grid_->resetAll();
+    tracker_.detach();
+    changedAll();
     visitedCount_ = 0;
     stack_.clear();
+    stack_.reserve(size_t(grid_->width()) * size_t(grid_->height()));
+    changes_.cells.reserve(changeLimit() + 2);
 
     std::random_device rd;
     uint64_t s = cfg_.seed == 0 ? ((static_cast<uint64_t>(rd()) << 32) ^ rd()) : cfg_.seed;
@@ -36,7 +38,7 @@ void MazeController::initPreview() {
     std::uniform_int_distribution<int> distY(0, grid_->height()-1);
     Coord start{distX(rng), distY(rng)};
     stack_.push_back(start);
-    grid_->at(start.x, start.y).visited = true;
+    grid_->setVisited(start.x, start.y);
     visitedCount_ = 1;
 }
 
@@ -45,13 +47,16 @@ bool MazeController::stepPreview() {
     if (stack_.empty()) { previewActive_ = false; return false; }
 
     Coord current = stack_.back();
-    auto neigh = neighbors4(*grid_, current);
-    std::vector<Coord> unvis;
-    for (auto &n : neigh) if (!grid_->at(n.x,n.y).visited) unvis.push_back(n);
-    if (!unvis.empty()) {
-        Coord n = unvis.back();
+    Coord neigh[4];
+    int count = neighbors4(*grid_, current, neigh);
+    int last = -1;
+    for (int i = 0; i < count; ++i) if (!grid_->visited(neigh[i].x,neigh[i].y)) last = i;
+    if (last >= 0) {
+        Coord n = neigh[last];
         grid_->removeWallBetween(current, n);
-        grid_->at(n.x,n.y).visited = true;
+        tracker_.wallChanged(current, n);
+        changed(current, n);
+        grid_->setVisited(n.x,n.y);
         stack_.push_back(n);
         visitedCount_++;
         return true;
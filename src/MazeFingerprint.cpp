@@ -0,0 +1,261 @@
+#include "MazeFingerprint.h"
+#include "MazeBits.h"
+#include "MazeIO.h"
+#include "MazeRandom.h"
+#include <QFile>
+#include <QByteArray>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace MazeFingerprint {
+
+namespace {
+
+// Bit i of a[j] becomes bit j of a[i]
+void transpose64(uint64_t a[64]) {
+    uint64_t m = 0x00000000FFFFFFFFull;
+    for (int j = 32; j != 0; j >>= 1, m ^= m << j)
+        for (int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+            const uint64_t t = ((a[k] >> j) ^ a[k | j]) & m;
+            a[k] ^= t << j;
+            a[k | j] ^= t;
+        }
+}
+
+// Plane of `rows` rows of `cols` bits (stride srcStride words) turned into
+// `cols` rows of `rows` bits, 64x64 blocks at a time
+void transposePlane(const uint64_t* src, size_t rows, size_t cols, size_t srcStride, std::vector<uint64_t>& dst) {
+    const size_t dstStride = MazeGrid::wordsForBits(rows);
+    dst.assign(cols * dstStride, 0);
+    uint64_t block[64];
+    for (size_t rb = 0; rb < dstStride; ++rb)
+        for (size_t cb = 0; cb < srcStride; ++cb) {
+            for (size_t i = 0; i < 64; ++i) {
+                const size_t r = rb * 64 + i;
+                block[i] = r < rows ? src[r * srcStride + cb] : 0;
+            }
+            transpose64(block);
+            for (size_t j = 0; j < 64 && cb * 64 + j < cols; ++j) dst[(cb * 64 + j) * dstStride + rb] = block[j];
+        }
+}
+
+// dst holds the `bits` bits of src in reverse order; padding stays zero
+void reverseRow(const uint64_t* src, uint64_t* dst, size_t words, size_t bits) {
+    const unsigned shift = unsigned(words * 64 - bits);
+    for (size_t k = 0; k < words; ++k) {
+        const uint64_t lo = reverseBits(src[words - 1 - k]);
+        const uint64_t hi = k + 1 < words ? reverseBits(src[words - 2 - k]) : 0;
+        dst[k] = shift ? (lo >> shift) | (hi << (64 - shift)) : lo;
+    }
+}
+
+// The transposed maze, in scratch's th/tv planes
+MazeGridView transpose(const MazeGridView& grid, Scratch& s) {
+    // North walls of the transposed maze are the original west walls and vice versa
+    const int w = grid.width(), h = grid.height();
+    transposePlane(grid.vWallRow(0), size_t(h), size_t(w) + 1, grid.vWordsPerRow(), s.th);
+    transposePlane(grid.hWallRow(0), size_t(h) + 1, size_t(w), grid.hWordsPerRow(), s.tv);
+    return MazeGridView(h, w, s.th.data(), s.tv.data());
+}
+
+// `grid` mirrored by the low two symmetry bits, in scratch's h/v planes
+MazeGridView mirror(const MazeGridView& grid, int symmetry, Scratch& s) {
+    const bool mirrorX = symmetry & 1, mirrorY = symmetry & 2;
+    const int w = grid.width(), h = grid.height();
+    const size_t hs = grid.hWordsPerRow(), vs = grid.vWordsPerRow();
+    s.h.resize(hs * size_t(h + 1));
+    s.v.resize(vs * size_t(h));
+    for (int r = 0; r <= h; ++r) {
+        uint64_t* dst = s.h.data() + size_t(mirrorY ? h - r : r) * hs;
+        if (mirrorX) reverseRow(grid.hWallRow(r), dst, hs, size_t(w));
+        else std::memcpy(dst, grid.hWallRow(r), hs * sizeof(uint64_t));
+    }
+    for (int y = 0; y < h; ++y) {
+        uint64_t* dst = s.v.data() + size_t(mirrorY ? h - 1 - y : y) * vs;
+        if (mirrorX) reverseRow(grid.vWallRow(y), dst, vs, size_t(w) + 1);
+        else std::memcpy(dst, grid.vWallRow(y), vs * sizeof(uint64_t));
+    }
+    return MazeGridView(w, h, s.h.data(), s.v.data());
+}
+
+// Batch file layout, see MazeGenerator::generateBatch
+constexpr char kBatchMagic[8] = {'M', 'Z', 'B', 'A', 'T', 'C', 'H', '1'};
+constexpr qint64 kBatchHeaderSize = 32;
+// Records per unit of work, by size, so workers share a large batch
+constexpr qint64 kBatchRunBytes = qint64(4) << 20;
+
+struct Unit {
+    int file = 0;
+    bool batch = false;
+    int width = 0, height = 0;
+    uint64_t first = 0, count = 0; // batch records
+};
+
+struct Hashed {
+    uint64_t fingerprint;
+    Entry entry;
+};
+
+size_t recordWords(int w, int h) {
+    return 1 + MazeGrid::wordsForBits(size_t(w)) * size_t(h + 1) + MazeGrid::wordsForBits(size_t(w) + 1) * size_t(h);
+}
+
+// Splits batch files into runs of records; other files are one unit each.
+// False if a batch header is unreadable or the file is shorter than it says.
+bool planUnits(const QString& path, int file, std::vector<Unit>& units) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    const QByteArray header = f.peek(kBatchHeaderSize);
+    if (!header.startsWith(QByteArray(kBatchMagic, 8))) {
+        units.push_back(Unit{file});
+        return true;
+    }
+    if (header.size() < kBatchHeaderSize) return false;
+    uint32_t w = 0, h = 0;
+    uint64_t count = 0;
+    std::memcpy(&w, header.constData() + 8, 4);
+    std::memcpy(&h, header.constData() + 12, 4);
+    std::memcpy(&count, header.constData() + 24, 8);
+    if (w == 0 || h == 0 || w > uint32_t(INT32_MAX - 1) || h > uint32_t(INT32_MAX - 1)) return false;
+    const qint64 recordBytes = qint64(recordWords(int(w), int(h)) * sizeof(uint64_t));
+    if (count > uint64_t((f.size() - kBatchHeaderSize) / recordBytes)) return false;
+    const uint64_t run = uint64_t(std::max<qint64>(1, kBatchRunBytes / recordBytes));
+    for (uint64_t first = 0; first < count; first += run)
+        units.push_back(Unit{file, true, int(w), int(h), first, std::min(run, count - first)});
+    return true;
+}
+
+}
+
+uint64_t hash(const MazeGridView& grid) {
+    uint64_t h = splitmix64((uint64_t(uint32_t(grid.width())) << 32) | uint32_t(grid.height()));
+    const size_t hs = grid.hWordsPerRow(), vs = grid.vWordsPerRow();
+    for (int r = 0; r <= grid.height(); ++r) {
+        const uint64_t* row = grid.hWallRow(r);
+        for (size_t k = 0; k < hs; ++k) h = splitmix64(h ^ row[k]);
+    }
+    for (int y = 0; y < grid.height(); ++y) {
+        const uint64_t* row = grid.vWallRow(y);
+        for (size_t k = 0; k < vs; ++k) h = splitmix64(h ^ row[k]);
+    }
+    return h;
+}
+
+MazeGrid transformed(const MazeGridView& grid, int symmetry) {
+    Scratch s;
+    MazeGridView t = symmetry & 4 ? transpose(grid, s) : grid;
+    if (symmetry & 3) t = mirror(t, symmetry, s);
+    MazeGrid out(t.width(), t.height());
+    for (int r = 0; r <= t.height(); ++r)
+        std::memcpy(out.hWallRow(r), t.hWallRow(r), t.hWordsPerRow() * sizeof(uint64_t));
+    for (int y = 0; y < t.height(); ++y)
+        std::memcpy(out.vWallRow(y), t.vWallRow(y), t.vWordsPerRow() * sizeof(uint64_t));
+    return out;
+}
+
+uint64_t canonicalHash(const MazeGridView& grid, Scratch& scratch) {
+    // One transpose serves the four symmetries that include it
+    uint64_t best = ~uint64_t(0);
+    for (const MazeGridView& base : {grid, transpose(grid, scratch)}) {
+        best = std::min(best, hash(base));
+        for (int m = 1; m < 4; ++m) best = std::min(best, hash(mirror(base, m, scratch)));
+    }
+    return best;
+}
+
+uint64_t canonicalHash(const MazeGridView& grid) {
+    Scratch scratch;
+    return canonicalHash(grid, scratch);
+}
+
+DedupResult findDuplicates(const QStringList& files, bool canonical, int threads) {
+    DedupResult result;
+    std::vector<Unit> units;
+    std::vector<char> failed(size_t(files.size()), 0);
+    for (int i = 0; i < files.size(); ++i)
+        if (!planUnits(files[i], i, units)) failed[size_t(i)] = 1;
+
+    std::vector<Hashed> all;
+    std::mutex merge;
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        std::vector<Hashed> local;
+        std::vector<int> localFailed;
+        Scratch scratch;
+        std::vector<uint64_t> records;
+        auto fingerprint = [&](const MazeGridView& g) { return canonical ? canonicalHash(g, scratch) : hash(g); };
+        for (size_t u = next++; u < units.size(); u = next++) {
+            const Unit& unit = units[u];
+            // A file that throws, say by needing more memory than there is,
+            // fails on its own instead of ending the run
+            const size_t kept = local.size();
+            try {
+                const QString& path = files[unit.file];
+                if (!unit.batch) {
+                    std::unique_ptr<MazeGrid> grid;
+                    MazeConfig cfg;
+                    if (MazeIO::loadCreate(grid, cfg, path)) local.push_back(Hashed{fingerprint(*grid), Entry{unit.file, false, 0}});
+                    else localFailed.push_back(unit.file);
+                    continue;
+                }
+                const size_t words = recordWords(unit.width, unit.height);
+                const qint64 bytes = qint64(unit.count * words * sizeof(uint64_t));
+                records.resize(size_t(unit.count) * words);
+                QFile f(path);
+                if (!f.open(QIODevice::ReadOnly) || !f.seek(kBatchHeaderSize + qint64(unit.first * words * sizeof(uint64_t))) ||
+                    f.read(reinterpret_cast<char*>(records.data()), bytes) != bytes) {
+                    localFailed.push_back(unit.file);
+                    continue;
+                }
+                const size_t hWords = MazeGrid::wordsForBits(size_t(unit.width)) * size_t(unit.height + 1);
+                for (uint64_t i = 0; i < unit.count; ++i) {
+                    const uint64_t* record = records.data() + size_t(i) * words; // seed, then the planes
+                    const MazeGridView view(unit.width, unit.height, record + 1, record + 1 + hWords);
+                    local.push_back(Hashed{fingerprint(view), Entry{unit.file, true, unit.first + i}});
+                }
+            } catch (...) {
+                local.erase(local.begin() + std::ptrdiff_t(kept), local.end());
+                localFailed.push_back(unit.file);
+            }
+        }
+        std::lock_guard<std::mutex> lock(merge);
+        all.insert(all.end(), local.begin(), local.end());
+        for (int file : localFailed) failed[size_t(file)] = 1;
+    };
+    const int hw = int(std::max(1u, std::thread::hardware_concurrency()));
+    const int workers = int(std::min<size_t>(units.size(), size_t(threads > 0 ? threads : hw)));
+    std::vector<std::thread> pool;
+    for (int i = 1; i < workers; ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+
+    result.mazes = all.size();
+    std::sort(all.begin(), all.end(), [](const Hashed& a, const Hashed& b) {
+        if (a.fingerprint != b.fingerprint) return a.fingerprint < b.fingerprint;
+        return a.entry.file != b.entry.file ? a.entry.file < b.entry.file : a.entry.index < b.entry.index;
+    });
+    for (size_t i = 0; i < all.size();) {
+        size_t end = i + 1;
+        while (end < all.size() && all[end].fingerprint == all[i].fingerprint) ++end;
+        if (end - i > 1) {
+            Group g;
+            g.fingerprint = all[i].fingerprint;
+            for (size_t k = i; k < end; ++k) g.members.push_back(all[k].entry);
+            result.groups.push_back(std::move(g));
+        }
+        i = end;
+    }
+    std::sort(result.groups.begin(), result.groups.end(), [](const Group& a, const Group& b) {
+        const Entry &x = a.members.front(), &y = b.members.front();
+        return x.file != y.file ? x.file < y.file : x.index < y.index;
+    });
+    for (int i = 0; i < files.size(); ++i)
+        if (failed[size_t(i)]) result.failed.push_back(i);
+    return result;
+}
+
+}
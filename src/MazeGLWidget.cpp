@@ -2,37 +2,89 @@
 #include <QMouseEvent>
 #include <QWheelEvent>
 #include <QKeyEvent>
+#include <algorithm>
 #include <cmath>
 
+// Vertices are MazeVertex: chunk-relative positions in hundredths of a cell
+// and axis-aligned normal and material IDs (MazeMesh::Normal, ::Material)
 static const char* kVertexShader = R"GLSL(
 #version 330 core
-layout(location=0) in vec3 aPos;
-layout(location=1) in vec3 aNormal;
-layout(location=2) in vec3 aColor;
-layout(location=3) in vec2 aUV;
+layout(location=0) in uvec3 aPos;
+layout(location=1) in uint aNormal;
+layout(location=2) in uint aMaterial;
 
 uniform mat4 uProj;
 uniform mat4 uView;
 uniform mat4 uModel;
+uniform vec2 uChunkOrigin; // cells
 
-out vec3 vColor;
+const vec3 kNormals[6] = vec3[6](vec3(1,0,0), vec3(-1,0,0), vec3(0,1,0), vec3(0,-1,0), vec3(0,0,1), vec3(0,0,-1));
+
+flat out uint vMaterial;
+out vec3 vNormal;
+out vec3 vFragPos;
+out vec2 vUV;
+
+void main(){
+    vec3 pos = vec3(aPos) * 0.01 + vec3(uChunkOrigin.x, 0.0, uChunkOrigin.y);
+    vec3 n = kNormals[aNormal];
+    vec4 worldPos = uModel * vec4(pos, 1.0);
+    gl_Position = uProj * uView * worldPos;
+    vFragPos = worldPos.xyz;
+    vNormal = mat3(uModel) * n;
+    vMaterial = aMaterial;
+    // Textures repeat once per cell: the floor in x and z, walls along their
+    // run and once over their 1.8 height
+    vUV = n.y != 0.0 ? pos.xz : vec2(n.x != 0.0 ? pos.z : pos.x, pos.y / 1.8);
+}
+)GLSL";
+
+// Walls are instances of MazeMesh::unitWall() (attributes 0..2), placed by a
+// MazeWallInstance (attribute 3): chunk-relative cell, length and axis
+static const char* kWallVertexShader = R"GLSL(
+#version 330 core
+layout(location=0) in uvec3 aPos;
+layout(location=1) in uint aNormal;
+layout(location=2) in uint aMaterial;
+layout(location=3) in uvec4 aWall;
+
+uniform mat4 uProj;
+uniform mat4 uView;
+uniform mat4 uModel;
+uniform vec2 uChunkOrigin; // cells
+
+const vec3 kNormals[6] = vec3[6](vec3(1,0,0), vec3(-1,0,0), vec3(0,1,0), vec3(0,-1,0), vec3(0,0,1), vec3(0,0,-1));
+
+flat out uint vMaterial;
 out vec3 vNormal;
 out vec3 vFragPos;
 out vec2 vUV;
 
 void main(){
-    vec4 worldPos = uModel * vec4(aPos, 1.0);
+    vec3 unit = vec3(aPos) * 0.01;
+    float along = unit.x * float(aWall.z);
+    vec3 n = kNormals[aNormal];
+    vec3 pos;
+    if (aWall.w == 0u) {
+        pos = vec3(float(aWall.x) + along, unit.y, float(aWall.y) + unit.z);
+    } else {
+        // A quarter turn about +y keeps the winding
+        pos = vec3(float(aWall.x) + unit.z, unit.y, float(aWall.y + aWall.z) - along);
+        n = vec3(n.z, 0.0, -n.x);
+    }
+    pos += vec3(uChunkOrigin.x, 0.0, uChunkOrigin.y);
+    vec4 worldPos = uModel * vec4(pos, 1.0);
     gl_Position = uProj * uView * worldPos;
     vFragPos = worldPos.xyz;
-    vNormal = mat3(uModel) * aNormal;
-    vColor = aColor;
-    vUV = aUV;
+    vNormal = mat3(uModel) * n;
+    vMaterial = aMaterial;
+    vUV = vec2(along, unit.y / 1.8);
 }
 )GLSL";
 
 static const char* kFragmentShader = R"GLSL(
 #version 330 core
-in vec3 vColor;
+flat in uint vMaterial;
 in vec3 vNormal;
 in vec3 vFragPos;
 in vec2 vUV;
@@ -47,6 +99,9 @@ uniform int uTheme; // 0 = flat, 1 = textured
 uniform sampler2D uWallTex;
 uniform sampler2D uFloorTex;
 
+// Floor, Wall, PathMarker
+const vec3 kColors[3] = vec3[3](vec3(0.15, 0.18, 0.22), vec3(0.6, 0.7, 0.8), vec3(1.0, 0.3, 0.3));
+
 void main(){
     vec3 n = normalize(vNormal);
     float diff = max(dot(n, -uLightDir), 0.0);
@@ -55,13 +110,11 @@ void main(){
     vec3 reflectDir = reflect(uLightDir, n);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), 16.0);
 
-    vec3 baseColor = vColor;
-    if (uTheme == 1) {
-        // Choose texture based on base color hint: floor uses darker base
-        bool isFloor = (vColor.r < 0.2 && vColor.g < 0.25);
+    vec3 baseColor = kColors[vMaterial];
+    if (uTheme == 1 && vMaterial != 2u) {
         vec3 wallTint = vec3(0.9, 0.9, 0.9);
         vec3 floorTint = vec3(0.8, 0.8, 0.8);
-        vec3 texColor = isFloor ? texture(uFloorTex, vUV).rgb * floorTint : texture(uWallTex, vUV).rgb * wallTint;
+        vec3 texColor = vMaterial == 0u ? texture(uFloorTex, vUV).rgb * floorTint : texture(uWallTex, vUV).rgb * wallTint;
         baseColor = mix(baseColor, texColor, 0.85);
     }
     vec3 color = baseColor * (uAmbient + diff * 0.85) + vec3(0.2) * spec;
@@ -83,7 +136,11 @@ MazeGLWidget::MazeGLWidget(QWidget* parent)
 MazeGLWidget::~MazeGLWidget() {
     makeCurrent();
     if (vbo_) glDeleteBuffers(1, &vbo_);
+    if (ebo_) glDeleteBuffers(1, &ebo_);
     if (vao_) glDeleteVertexArrays(1, &vao_);
+    if (unitWallVbo_) glDeleteBuffers(1, &unitWallVbo_);
+    if (wallVbo_) glDeleteBuffers(1, &wallVbo_);
+    if (wallVao_) glDeleteVertexArrays(1, &wallVao_);
     if (wallTex_) glDeleteTextures(1, &wallTex_);
     if (floorTex_) glDeleteTextures(1, &floorTex_);
     doneCurrent();
@@ -95,10 +152,16 @@ void MazeGLWidget::initializeGL() {
 
     glClearColor(0.08f, 0.1f, 0.12f, 1.0f);
     glEnable(GL_DEPTH_TEST);
+    // MazeMesh emits both sides of every wall, wound counter-clockwise
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
 
     program_.addShaderFromSourceCode(QOpenGLShader::Vertex, kVertexShader);
     program_.addShaderFromSourceCode(QOpenGLShader::Fragment, kFragmentShader);
     program_.link();
+    wallProgram_.addShaderFromSourceCode(QOpenGLShader::Vertex, kWallVertexShader);
+    wallProgram_.addShaderFromSourceCode(QOpenGLShader::Fragment, kFragmentShader);
+    wallProgram_.link();
 
     createProceduralTextures();
 
@@ -122,7 +185,6 @@ void MazeGLWidget::resizeGL(int w, int h) {
 void MazeGLWidget::paintGL() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    program_.bind();
     if (!frameTimer_.isValid()) frameTimer_.start();
     frameCount_++;
     if (frameTimer_.elapsed() >= 1000) {
@@ -134,30 +196,65 @@ void MazeGLWidget::paintGL() {
 
     QMatrix4x4 proj = computeProjMatrix();
     QMatrix4x4 view = computeViewMatrix();
-    QMatrix4x4 model; // identity
-
-    program_.setUniformValue("uProj", proj);
-    program_.setUniformValue("uView", view);
-    program_.setUniformValue("uModel", model);
-
-    // Extract view position from inverted view matrix
-    QMatrix4x4 invView = view.inverted();
-    QVector3D viewPos = invView.column(3).toVector3D();
-    program_.setUniformValue("uViewPos", viewPos);
-    program_.setUniformValue("uTheme", themeMode_==ThemeMode::Textured ? 1 : 0);
 
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, wallTex_);
-    program_.setUniformValue("uWallTex", 0);
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D, floorTex_);
-    program_.setUniformValue("uFloorTex", 1);
 
+    // Only chunks whose bounding box reaches into the view are drawn
+    const QMatrix4x4 viewProj = proj * view;
+    const MazeMesh::Frustum frustum(viewProj.constData());
+    visibleChunks_.clear();
+    for (const MazeMesh::Chunk& c : mesh_.chunks)
+        if (frustum.intersects(c)) visibleChunks_.push_back(&c);
+    geometryStats_.chunksDrawn = visibleChunks_.size();
+    geometryStats_.chunksCulled = mesh_.chunks.size() - visibleChunks_.size();
+
+    // Floor and path: one draw per chunk, as indices are 16-bit and count
+    // from the chunk's first vertex
+    setCommonUniforms(program_, proj, view);
+    int chunkOrigin = program_.uniformLocation("uChunkOrigin");
     glBindVertexArray(vao_);
-    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLint>(vertices_.size()));
+    for (const MazeMesh::Chunk* c : visibleChunks_) {
+        if (!c->indexCount) continue;
+        program_.setUniformValue(chunkOrigin, float(c->originX), float(c->originZ));
+        glDrawElementsBaseVertex(GL_TRIANGLES, GLsizei(c->indexCount), GL_UNSIGNED_SHORT,
+                                 reinterpret_cast<void*>(size_t(c->firstIndex) * sizeof(uint16_t)), GLint(c->firstVertex));
+    }
+    program_.release();
+
+    // Walls: the unit wall instanced over each chunk's runs. GL 3.3 has no
+    // base instance, so the instance attribute is pointed at the chunk's range.
+    setCommonUniforms(wallProgram_, proj, view);
+    chunkOrigin = wallProgram_.uniformLocation("uChunkOrigin");
+    glBindVertexArray(wallVao_);
+    glBindBuffer(GL_ARRAY_BUFFER, wallVbo_);
+    for (const MazeMesh::Chunk* c : visibleChunks_) {
+        if (!c->wallCount) continue;
+        wallProgram_.setUniformValue(chunkOrigin, float(c->originX), float(c->originZ));
+        glVertexAttribIPointer(3, 4, GL_UNSIGNED_BYTE, sizeof(MazeWallInstance),
+                               reinterpret_cast<void*>(size_t(c->firstWall) * sizeof(MazeWallInstance)));
+        glDrawArraysInstanced(GL_TRIANGLES, 0, MazeMesh::kUnitWallVertices, GLsizei(c->wallCount));
+    }
     glBindVertexArray(0);
+    wallProgram_.release();
+}
 
-    program_.release();
+void MazeGLWidget::setCommonUniforms(QOpenGLShaderProgram& program, const QMatrix4x4& proj, const QMatrix4x4& view) {
+    program.bind();
+    QMatrix4x4 model; // identity
+    program.setUniformValue("uProj", proj);
+    program.setUniformValue("uView", view);
+    program.setUniformValue("uModel", model);
+
+    // Extract view position from inverted view matrix
+    QMatrix4x4 invView = view.inverted();
+    QVector3D viewPos = invView.column(3).toVector3D();
+    program.setUniformValue("uViewPos", viewPos);
+    program.setUniformValue("uTheme", themeMode_==ThemeMode::Textured ? 1 : 0);
+    program.setUniformValue("uWallTex", 0);
+    program.setUniformValue("uFloorTex", 1);
 }
 
 void MazeGLWidget::mousePressEvent(QMouseEvent* e) {
@@ -284,103 +381,95 @@ void MazeGLWidget::rotationTriggered(QRotationGesture* gesture) {
 }
 
 void MazeGLWidget::buildMaze() {
-    vertices_.clear();
-    const MazeGrid& grid = controller_->grid();
-
-    const float wallH = 1.8f;
-    const float baseY = 0.0f;
-    const QVector3D wallColor(0.6f, 0.7f, 0.8f);
-    const QVector3D floorColor(0.15f, 0.18f, 0.22f);
-
-    // Floor
-    addQuad(QVector3D(0, baseY, 0), QVector3D(grid.width(), baseY, 0), QVector3D(grid.width(), baseY, grid.height()), QVector3D(0, baseY, grid.height()), QVector3D(0,1,0), floorColor);
-
-    // Walls
-    for (int y = 0; y < grid.height(); ++y) {
-        for (int x = 0; x < grid.width(); ++x) {
-            const Cell& c = grid.at(x,y);
-            float fx = static_cast<float>(x);
-            float fz = static_cast<float>(y);
-            if (c.wallN) {
-                QVector3D a(fx, baseY, fz);
-                QVector3D b(fx+1, baseY, fz);
-                QVector3D c1(fx+1, baseY+wallH, fz);
-                QVector3D d(fx, baseY+wallH, fz);
-                addQuad(a,b,c1,d, QVector3D(0,0,-1), wallColor);
-            }
-            if (c.wallS) {
-                QVector3D a(fx, baseY, fz+1);
-                QVector3D b(fx+1, baseY, fz+1);
-                QVector3D c1(fx+1, baseY+wallH, fz+1);
-                QVector3D d(fx, baseY+wallH, fz+1);
-                addQuad(d,c1,b,a, QVector3D(0,0,1), wallColor);
-            }
-            if (c.wallW) {
-                QVector3D a(fx, baseY, fz);
-                QVector3D b(fx, baseY, fz+1);
-                QVector3D c1(fx, baseY+wallH, fz+1);
-                QVector3D d(fx, baseY+wallH, fz);
-                addQuad(d,c1,b,a, QVector3D(-1,0,0), wallColor);
-            }
-            if (c.wallE) {
-                QVector3D a(fx+1, baseY, fz);
-                QVector3D b(fx+1, baseY, fz+1);
-                QVector3D c1(fx+1, baseY+wallH, fz+1);
-                QVector3D d(fx+1, baseY+wallH, fz);
-                addQuad(a,b,c1,d, QVector3D(1,0,0), wallColor);
-            }
-        }
-    }
+    QElapsedTimer timer;
+    timer.start();
+    controller_->takeChanges(changes_); // covered by the full rebuild
+    MazeMesh::buildMaze(controller_->grid(), mesh_);
 
     // Path overlay
     buildPathGeometry();
+    geometryStats_.buildMs = timer.nsecsElapsed() / 1e6;
 }
 
 void MazeGLWidget::buildPathGeometry(){
-    if (path_.empty()) return;
-    const float baseY = 0.02f;
-    const QVector3D pathColor(1.0f, 0.3f, 0.3f);
-    for (const auto &c : path_) {
-        float fx = float(c.x);
-        float fz = float(c.y);
-        QVector3D a(fx+0.15f, baseY, fz+0.15f);
-        QVector3D b(fx+0.85f, baseY, fz+0.15f);
-        QVector3D c1(fx+0.85f, baseY, fz+0.85f);
-        QVector3D d(fx+0.15f, baseY, fz+0.85f);
-        addQuad(a,b,c1,d, QVector3D(0,1,0), pathColor);
-    }
-}
-
-void MazeGLWidget::addQuad(const QVector3D& a, const QVector3D& b, const QVector3D& c, const QVector3D& d, const QVector3D& normal, const QVector3D& color) {
-    vertices_.push_back({a, normal, color, QVector2D(0.0f,0.0f)});
-    vertices_.push_back({b, normal, color, QVector2D(1.0f,0.0f)});
-    vertices_.push_back({c, normal, color, QVector2D(1.0f,1.0f)});
-    vertices_.push_back({a, normal, color, QVector2D(0.0f,0.0f)});
-    vertices_.push_back({c, normal, color, QVector2D(1.0f,1.0f)});
-    vertices_.push_back({d, normal, color, QVector2D(0.0f,1.0f)});
+    MazeMesh::appendPath(path_, mesh_);
 }
 
-}
 void MazeGLWidget::uploadGeometry() {
-    if (!vao_) glGenVertexArrays(1, &vao_);
-    if (!vbo_) glGenBuffers(1, &vbo_);
+    // Attributes 0..2 from the bound MazeVertex buffer, read as integers and
+    // decoded by the shaders
+    auto vertexAttributes = [this]() {
+        glEnableVertexAttribArray(0);
+        glVertexAttribIPointer(0, 3, GL_UNSIGNED_SHORT, sizeof(MazeVertex), reinterpret_cast<void*>(offsetof(MazeVertex, pos)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribIPointer(1, 1, GL_UNSIGNED_BYTE, sizeof(MazeVertex), reinterpret_cast<void*>(offsetof(MazeVertex, normal)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribIPointer(2, 1, GL_UNSIGNED_BYTE, sizeof(MazeVertex), reinterpret_cast<void*>(offsetof(MazeVertex, material)));
+    };
+    if (!vao_) {
+        glGenVertexArrays(1, &vao_);
+        glGenBuffers(1, &vbo_);
+        glGenBuffers(1, &ebo_);
+        glBindVertexArray(vao_);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+        vertexAttributes();
+    }
+    if (!wallVao_) {
+        // The unit wall never changes; paintGL points attribute 3 at each chunk's instances
+        glGenVertexArrays(1, &wallVao_);
+        glGenBuffers(1, &unitWallVbo_);
+        glGenBuffers(1, &wallVbo_);
+        glBindVertexArray(wallVao_);
+        glBindBuffer(GL_ARRAY_BUFFER, unitWallVbo_);
+        glBufferData(GL_ARRAY_BUFFER, MazeMesh::kUnitWallVertices * sizeof(MazeVertex), MazeMesh::unitWall(), GL_STATIC_DRAW);
+        vertexAttributes();
+        glEnableVertexAttribArray(3);
+        glVertexAttribDivisor(3, 1);
+    }
 
+    // Times the driver taking the copies, not the transfer itself
+    QElapsedTimer timer;
+    timer.start();
     glBindVertexArray(vao_);
     glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER, vertices_.size() * sizeof(Vertex), vertices_.data(), GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex,pos)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex,normal)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex,color)));
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex,uv)));
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(mesh_.vertexBytes()), mesh_.vertices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, GLsizeiptr(mesh_.indexBytes()), mesh_.indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, wallVbo_);
+    glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(mesh_.wallBytes()), mesh_.walls.data(), GL_STATIC_DRAW);
+    geometryStats_.uploadMs = timer.nsecsElapsed() / 1e6;
+    geometryStats_.vertexBytes = mesh_.vertexBytes();
+    geometryStats_.indexBytes = mesh_.indexBytes();
+    geometryStats_.wallBytes = mesh_.wallBytes();
 
     glBindVertexArray(0);
 }
 
+void MazeGLWidget::updateWalls(const std::vector<Coord>& cells) {
+    // A changed wall lies in the chunk of one of the cells either side of it,
+    // so only those chunks are rebuilt and written over their buffer slots
+    QElapsedTimer timer;
+    timer.start();
+    const MazeGrid& grid = controller_->grid();
+    std::vector<int>& dirty = dirtyChunks_;
+    dirty.clear();
+    for (const Coord& c : cells) dirty.push_back(MazeMesh::chunkAt(grid, c.x, c.y));
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+    for (int chunk : dirty) MazeMesh::rebuildWalls(grid, mesh_, chunk);
+    geometryStats_.buildMs = timer.nsecsElapsed() / 1e6;
+
+    timer.restart();
+    glBindBuffer(GL_ARRAY_BUFFER, wallVbo_);
+    for (int chunk : dirty) {
+        const MazeMesh::Chunk& c = mesh_.chunks[size_t(chunk)];
+        glBufferSubData(GL_ARRAY_BUFFER, GLintptr(c.firstWall * sizeof(MazeWallInstance)),
+                        GLsizeiptr(c.wallCount * sizeof(MazeWallInstance)), mesh_.walls.data() + c.firstWall);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    geometryStats_.uploadMs = timer.nsecsElapsed() / 1e6;
+}
+
 QMatrix4x4 MazeGLWidget::computeViewMatrix() const {
     QMatrix4x4 view;
     if (cameraMode_ == CameraMode::Orbit) {
@@ -463,7 +552,8 @@ bool MazeGLWidget::resolveCollision(QVector3D& pos, const QVector3D& desiredDelt
 
 void MazeGLWidget::regenerateMaze(const MazeConfig& cfg){
     cfg_ = cfg;
-    controller_ = std::make_unique<MazeController>(cfg_.width, cfg_.height);
+    // The controller is kept across mazes so its solve cache survives
+    if (!controller_) controller_ = std::make_unique<MazeController>(cfg_.width, cfg_.height);
     controller_->regenerate(cfg_);
     path_.clear();
     buildMaze();
@@ -473,7 +563,7 @@ void MazeGLWidget::regenerateMaze(const MazeConfig& cfg){
 
 void MazeGLWidget::startPreview(const MazeConfig& cfg){
     cfg_ = cfg;
-    controller_ = std::make_unique<MazeController>(cfg_.width, cfg_.height);
+    if (!controller_) controller_ = std::make_unique<MazeController>(cfg_.width, cfg_.height);
     controller_->startPreview(cfg_);
     path_.clear();
     buildMaze();
@@ -486,8 +576,13 @@ void MazeGLWidget::stepPreview(){
     if (controller_->previewActive()){
         controller_->stepPreview();
         emit previewProgress(controller_->previewProgress());
-        buildMaze();
-        uploadGeometry();
+        controller_->takeChanges(changes_);
+        if (changes_.all) {
+            buildMaze();
+            uploadGeometry();
+        } else {
+            updateWalls(changes_.cells);
+        }
         update();
     }
 }
@@ -495,7 +590,7 @@ void MazeGLWidget::stepPreview(){
 void MazeGLWidget::runSolver(){
     const MazeGrid& g = controller_->grid();
     if (goal_.x == 0 && goal_.y == 0){ goal_ = {g.width()-1, g.height()-1}; }
-    auto res = MazeSolver::solveBFS(g, start_, goal_);
+    auto res = controller_->solve(solver_, start_, goal_, &solveStats_);
     if (res){ path_ = res->nodes; } else { path_.clear(); }
     buildMaze();
     uploadGeometry();
@@ -513,8 +608,8 @@ void MazeGLWidget::setStartGoal(Coord s, Coord g){ start_=s; goal_=g; }
 
 void MazeGLWidget::loadGridAndConfig(const MazeGrid& grid, const MazeConfig& cfg){
     cfg_ = cfg;
-    controller_ = std::make_unique<MazeController>(grid.width(), grid.height());
-    controller_->regenerate(cfg_);
+    if (!controller_) controller_ = std::make_unique<MazeController>(grid.width(), grid.height());
+    controller_->resize(grid.width(), grid.height());
     controller_->applyFromGrid(grid);
     emit mazeConfigLoaded(cfg_);
     path_.clear();
@@ -536,6 +631,9 @@ void MazeGLWidget::createProceduralTextures(){
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, glImg.width(), glImg.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, glImg.constBits());
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        // Merged wall runs and the floor tile the texture once per cell
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glGenerateMipmap(GL_TEXTURE_2D);
         glBindTexture(GL_TEXTURE_2D, 0);
     };
@@ -1,93 +1,502 @@
 #include "MazeGenerator.h"
-#include <stack>
+#include "MazeBits.h"
+#include "MazeRandom.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
 
 namespace {
-struct Neighbor { Coord pos; Coord from; };
-
-std::vector<Coord> neighbors4(const MazeGrid& grid, const Coord& c) {
-    static const int dx[4] = {0, 1, 0, -1};
-    static const int dy[4] = {-1, 0, 1, 0};
-    std::vector<Coord> res;
-    for (int i = 0; i < 4; ++i) {
-        int nx = c.x + dx[i];
-        int ny = c.y + dy[i];
-        if (grid.inBounds(nx, ny)) res.push_back({nx, ny});
-    }
-    return res;
+const int kDx[4] = {0, 1, 0, -1};
+const int kDy[4] = {-1, 0, 1, 0};
+
+bool inRegion(const MazeRect& r, int x, int y) {
+    return x >= r.x && y >= r.y && x < r.x + r.width && y < r.y + r.height;
+}
+
+// Tile columns are multiples of 64 cells wide so that no two tiles ever write
+// to the same bitplane word; rows can be split anywhere.
+std::vector<int> splitSpan(int total, int parts, int align) {
+    // 64-bit so spans near INT_MAX do not overflow while rounding
+    int64_t size = (int64_t(total) + parts - 1) / parts;
+    size = ((size + align - 1) / align) * align;
+    std::vector<int> starts;
+    for (int64_t s = 0; s < total; s += size) starts.push_back(int(s));
+    starts.push_back(total);
+    return starts;
+}
+
+// Tiles for about `parts` workers, row by row
+std::vector<MazeRect> splitTiles(int W, int H, int parts) {
+    int wantX = std::min(parts, std::max(1, W / 64));
+    std::vector<int> xs = splitSpan(W, wantX, 64);
+    int tilesX = int(xs.size()) - 1;
+    std::vector<int> ys = splitSpan(H, std::min(H, (parts + tilesX - 1) / tilesX), 1);
+    int tilesY = int(ys.size()) - 1;
+    std::vector<MazeRect> tiles;
+    for (int ty = 0; ty < tilesY; ++ty)
+        for (int tx = 0; tx < tilesX; ++tx)
+            tiles.push_back({xs[tx], ys[ty], xs[tx+1] - xs[tx], ys[ty+1] - ys[ty]});
+    return tiles;
+}
+
+bool testBit(const uint64_t* row, int i) { return (row[i >> 6] >> (i & 63)) & 1u; }
+void clearBit(uint64_t* row, int i) { row[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+void fillRow(std::vector<uint64_t>& row, size_t bits) {
+    std::fill(row.begin(), row.end(), ~uint64_t(0));
+    row.back() = MazeGrid::tailMask(bits);
 }
 }
 
+uint64_t MazeGenerator::resolveSeed(uint64_t seed) {
+    if (seed != 0) return seed;
+    std::random_device rd;
+    while (seed == 0) seed = (static_cast<uint64_t>(rd()) << 32) ^ rd();
+    return seed;
+}
+
 void MazeGenerator::generate(MazeGrid& grid, const MazeConfig& cfg) {
+    Workspace ws;
+    generate(grid, cfg, ws);
+}
+
+void MazeGenerator::generate(MazeGrid& grid, const MazeConfig& cfg, Workspace& ws) {
     // Reset grid: all walls up, visited false
-    for (int y = 0; y < grid.height(); ++y) for (int x = 0; x < grid.width(); ++x) {
-        auto &cell = grid.at(x,y);
-        cell.visited = false;
-        cell.wallN = cell.wallE = cell.wallS = cell.wallW = true;
+    grid.resetAll();
+
+    uint64_t s = resolveSeed(cfg.seed);
+    switch (cfg.rng) {
+        case MazeRng::Mt19937_64:
+            generateWith<std::mt19937_64>(grid, cfg, s, ws);
+            break;
+        case MazeRng::Xoshiro256StarStar:
+            generateWith<Xoshiro256StarStar>(grid, cfg, s, ws);
+            break;
+        case MazeRng::Pcg64:
+            generateWith<Pcg64>(grid, cfg, s, ws);
+            break;
     }
+}
 
-    std::random_device rd;
-    uint64_t s = cfg.seed == 0 ? ((static_cast<uint64_t>(rd()) << 32) ^ rd()) : cfg.seed;
-    std::mt19937_64 rng(s);
+template <class Rng>
+void MazeGenerator::generateWith(MazeGrid& grid, const MazeConfig& cfg, uint64_t seed, Workspace& ws) {
+    int threads = cfg.threads == 0 ? int(std::max(1u, std::thread::hardware_concurrency())) : cfg.threads;
+    const bool indexed = cfg.algorithm == MazeAlgorithm::Prims || cfg.algorithm == MazeAlgorithm::Kruskal;
+    if (threads > 1 || (indexed && int64_t(grid.width()) * grid.height() > kMaxIndexedRegionCells)) {
+        generateTiled<Rng>(grid, cfg.algorithm, seed, threads);
+        return;
+    }
+    Rng rng(seed);
+    carveRegion(grid, MazeRect{0, 0, grid.width(), grid.height()}, cfg.algorithm, rng, ws);
+}
 
-    switch (cfg.algorithm) {
+template <class Rng>
+void MazeGenerator::carveRegion(MazeGrid& grid, const MazeRect& region, MazeAlgorithm alg, Rng& rng, Workspace& ws) {
+    switch (alg) {
         case MazeAlgorithm::RecursiveBacktracking:
-            genRecursiveBacktracking(grid, rng);
+            genRecursiveBacktracking(grid, region, rng, ws);
             break;
         case MazeAlgorithm::Prims:
-            genPrims(grid, rng);
+            genPrims(grid, region, rng, ws);
+            break;
+        case MazeAlgorithm::Eller:
+            genEller(grid, region, rng, ws);
+            break;
+        case MazeAlgorithm::Kruskal:
+            genKruskal(grid, region, rng, ws);
+            break;
+    }
+}
+
+void MazeGenerator::generateRows(const MazeConfig& cfg, const RowSink& sink) {
+    if (cfg.width <= 0 || cfg.height <= 0) return;
+    Workspace ws;
+    uint64_t s = resolveSeed(cfg.seed);
+    switch (cfg.rng) {
+        case MazeRng::Mt19937_64: {
+            std::mt19937_64 rng(s);
+            ellerRows(cfg.width, cfg.height, rng, ws, sink);
+            break;
+        }
+        case MazeRng::Xoshiro256StarStar: {
+            Xoshiro256StarStar rng(s);
+            ellerRows(cfg.width, cfg.height, rng, ws, sink);
+            break;
+        }
+        case MazeRng::Pcg64: {
+            Pcg64 rng(s);
+            ellerRows(cfg.width, cfg.height, rng, ws, sink);
             break;
+        }
+    }
+}
+
+MazeGenerator::BatchStats MazeGenerator::generateBatch(const MazeConfig& cfg, uint64_t firstSeed, uint64_t count,
+                                                       const BatchSink& sink, int threads) {
+    using Clock = std::chrono::steady_clock;
+    const auto t0 = Clock::now();
+    if (threads <= 0) threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    threads = int(std::min<uint64_t>(uint64_t(threads), std::max<uint64_t>(count, 1)));
+
+    // Seeds are claimed in increasing order; a finished maze waits for its turn
+    // so the sink sees seeds in order without buffering more than one maze per worker.
+    std::atomic<uint64_t> nextClaim{0};
+    uint64_t nextEmit = 0;
+    std::mutex emitMutex;
+    std::condition_variable emitTurn;
+    auto worker = [&]() {
+        MazeConfig c = cfg;
+        c.threads = 1;
+        MazeGrid grid(cfg.width, cfg.height);
+        Workspace ws;
+        for (uint64_t i = nextClaim++; i < count; i = nextClaim++) {
+            c.seed = firstSeed + i;
+            generate(grid, c, ws);
+            std::unique_lock<std::mutex> lock(emitMutex);
+            emitTurn.wait(lock, [&]() { return nextEmit == i; });
+            sink(c.seed, grid);
+            ++nextEmit;
+            emitTurn.notify_all();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+
+    BatchStats stats;
+    stats.mazes = count;
+    stats.seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    stats.mazesPerSecond = stats.seconds > 0.0 ? double(count) / stats.seconds : 0.0;
+    return stats;
+}
+
+MazeGenerator::BatchStats MazeGenerator::generateBatch(const MazeConfig& cfg, uint64_t firstSeed, uint64_t count,
+                                                       std::ostream& out, int threads) {
+    auto put32 = [&](uint32_t v) { out.write(reinterpret_cast<const char*>(&v), sizeof v); };
+    auto put64 = [&](uint64_t v) { out.write(reinterpret_cast<const char*>(&v), sizeof v); };
+    out.write("MZBATCH1", 8);
+    put32(uint32_t(cfg.width));
+    put32(uint32_t(cfg.height));
+    put32(uint32_t(cfg.algorithm));
+    put32(uint32_t(cfg.rng));
+    put64(count);
+    auto writePlane = [&](const std::vector<uint64_t>& words) {
+        out.write(reinterpret_cast<const char*>(words.data()), std::streamsize(words.size() * sizeof(uint64_t)));
+    };
+    return generateBatch(cfg, firstSeed, count, [&](uint64_t seed, const MazeGrid& grid) {
+        put64(seed);
+        writePlane(grid.hWallWords());
+        writePlane(grid.vWallWords());
+    }, threads);
+}
+
+std::vector<MazeRect> MazeGenerator::planTiles(int w, int h, MazeAlgorithm alg, int threads) {
+    const bool indexed = alg == MazeAlgorithm::Prims || alg == MazeAlgorithm::Kruskal;
+    auto fits = [&](const std::vector<MazeRect>& tiles) {
+        for (const MazeRect& t : tiles)
+            if (int64_t(t.width) * t.height > kMaxIndexedRegionCells) return false;
+        return true;
+    };
+    // More tiles than workers only when a region would overflow the indices
+    std::vector<MazeRect> tiles = splitTiles(w, h, std::max(1, threads));
+    for (int parts = std::max(1, threads) * 2; indexed && !fits(tiles); parts *= 2) tiles = splitTiles(w, h, parts);
+    return tiles;
+}
+
+template <class Rng>
+void MazeGenerator::generateTiled(MazeGrid& grid, MazeAlgorithm alg, uint64_t seed, int threads) {
+    const std::vector<MazeRect> tiles = planTiles(grid.width(), grid.height(), alg, threads);
+    int tilesX = 0;
+    while (tilesX < int(tiles.size()) && tiles[size_t(tilesX)].y == 0) ++tilesX;
+    const int tilesY = int(tiles.size()) / tilesX;
+
+    // Tiles are claimed dynamically, but each one has its own seed, so the
+    // result does not depend on which thread carves it.
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        Workspace ws;
+        for (size_t t = next++; t < tiles.size(); t = next++) {
+            Rng rng(splitmix64(seed ^ splitmix64(t + 1)));
+            carveRegion(grid, tiles[t], alg, rng, ws);
+        }
+    };
+    int nThreads = std::min<int>(threads, int(tiles.size()));
+    std::vector<std::thread> pool;
+    for (int i = 1; i < nThreads; ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool) th.join();
+
+    if (tiles.size() == 1) return;
+
+    // Join the tiles: a random spanning tree over the tile grid, with one
+    // opening at a random position along each seam it uses.
+    Rng seamRng(splitmix64(seed));
+    Workspace ws;
+    MazeGrid tileGrid(tilesX, tilesY);
+    genRecursiveBacktracking(tileGrid, MazeRect{0, 0, tilesX, tilesY}, seamRng, ws);
+    for (int ty = 0; ty < tilesY; ++ty) {
+        for (int tx = 0; tx < tilesX; ++tx) {
+            const MazeRect& t = tiles[size_t(ty) * tilesX + tx];
+            if (tx + 1 < tilesX && !tileGrid.wallE(tx, ty)) {
+                int y = t.y + int(randomBelow(seamRng, uint64_t(t.height)));
+                grid.removeWallBetween({t.x + t.width - 1, y}, {t.x + t.width, y});
+            }
+            if (ty + 1 < tilesY && !tileGrid.wallS(tx, ty)) {
+                int x = t.x + int(randomBelow(seamRng, uint64_t(t.width)));
+                grid.removeWallBetween({x, t.y + t.height - 1}, {x, t.y + t.height});
+            }
+        }
+    }
+}
+
+template <class Rng>
+void MazeGenerator::genRecursiveBacktracking(MazeGrid& grid, const MazeRect& region, Rng& rng, Workspace& ws) {
+    Coord current{region.x + int(randomBelow(rng, uint64_t(region.width))),
+                  region.y + int(randomBelow(rng, uint64_t(region.height)))};
+    grid.setVisited(current.x, current.y);
+
+    // The stack holds the direction of each step, so backtracking retraces the
+    // path without storing coordinates.
+    std::vector<uint8_t>& st = ws.stack;
+    st.clear();
+    st.reserve(size_t(region.width) * size_t(region.height));
+
+    for (;;) {
+        int open[4];
+        int count = 0;
+        for (int d = 0; d < 4; ++d) {
+            int nx = current.x + kDx[d], ny = current.y + kDy[d];
+            if (inRegion(region, nx, ny) && !grid.visited(nx, ny)) open[count++] = d;
+        }
+        if (count > 0) {
+            int d = open[count == 1 ? 0 : randomBelow(rng, uint64_t(count))];
+            Coord n{current.x + kDx[d], current.y + kDy[d]};
+            grid.removeWallBetween(current, n);
+            grid.setVisited(n.x, n.y);
+            st.push_back(uint8_t(d));
+            current = n;
+        } else {
+            if (st.empty()) break;
+            int d = st.back();
+            st.pop_back();
+            current.x -= kDx[d];
+            current.y -= kDy[d];
+        }
+    }
+}
+
+template <class Rng>
+void MazeGenerator::genPrims(MazeGrid& grid, const MazeRect& region, Rng& rng, Workspace& ws) {
+    const int32_t rw = region.width, rh = region.height;
+    const int32_t n = rw * rh;
+
+    // Frontier cells are kept once each (tracked in a bitset) and removed by
+    // swapping with the last entry, so every step is O(1). Whether a neighbour
+    // is carved or queued is random, so it is folded into masks and counts
+    // rather than branched on.
+    std::vector<int32_t>& frontier = ws.frontier;
+    std::vector<uint64_t>& queued = ws.marks;
+    std::vector<uint64_t>& carved = ws.carved;
+    if (frontier.size() < size_t(n)) frontier.resize(size_t(n));
+    queued.assign(MazeGrid::wordsForBits(size_t(n)), 0);
+    carved.assign(MazeGrid::wordsForBits(size_t(n)), 0);
+    auto bitOf = [](const std::vector<uint64_t>& v, int32_t i) { return unsigned(v[size_t(i) >> 6] >> (i & 63)) & 1u; };
+    size_t size = 0;
+
+    // Neighbours N, E, S, W of cell i; one outside the region is replaced by
+    // i itself, which is queued or carved whenever it is looked at
+    int32_t nb[4];
+    auto neighbours = [&](int32_t i, int32_t x, int32_t y) {
+        nb[0] = y > 0 ? i - rw : i;
+        nb[1] = x + 1 < rw ? i + 1 : i;
+        nb[2] = y + 1 < rh ? i + rw : i;
+        nb[3] = x > 0 ? i - 1 : i;
+    };
+    auto carve = [&](int32_t i) {
+        carved[size_t(i) >> 6] |= uint64_t(1) << (i & 63);
+        for (int32_t j : nb) {
+            const unsigned add = (bitOf(carved, j) | bitOf(queued, j)) ^ 1u;
+            queued[size_t(j) >> 6] |= uint64_t(add) << (j & 63);
+            frontier[size] = j;
+            size += add;
+        }
+    };
+
+    const int32_t start = int32_t(randomBelow(rng, uint64_t(n)));
+    neighbours(start, start % rw, start / rw);
+    carve(start);
+
+    while (size) {
+        const size_t idx = size_t(randomBelow(rng, size));
+        const int32_t i = frontier[idx];
+        frontier[idx] = frontier[--size];
+        const int32_t y = i / rw, x = i - y * rw;
+        neighbours(i, x, y);
+
+        // Attach to a random neighbour that is already part of the maze
+        unsigned in = 0;
+        for (int d = 0; d < 4; ++d) in |= bitOf(carved, nb[d]) << d;
+        const int count = popCount(in);
+        for (int k = count == 1 ? 0 : int(randomBelow(rng, uint64_t(count))); k > 0; --k) in &= in - 1;
+        const int d = lowestBit(in);
+        const Coord c{region.x + x, region.y + y};
+        grid.removeWallBetween(c, {c.x + kDx[d], c.y + kDy[d]});
+        carve(i);
     }
+    for (int32_t y = 0; y < rh; ++y)
+        for (int32_t x = 0; x < rw; ++x) grid.setVisited(region.x + x, region.y + y);
 }
 
-void MazeGenerator::genRecursiveBacktracking(MazeGrid& grid, std::mt19937_64& rng) {
-    std::uniform_int_distribution<int> distX(0, grid.width()-1);
-    std::uniform_int_distribution<int> distY(0, grid.height()-1);
-    Coord start{distX(rng), distY(rng)};
-
-    std::stack<Coord> st;
-    st.push(start);
-    grid.at(start.x, start.y).visited = true;
-
-    while (!st.empty()) {
-        Coord current = st.top();
-        auto neigh = neighbors4(grid, current);
-        std::shuffle(neigh.begin(), neigh.end(), rng);
-
-        bool carved = false;
-        for (const auto &n : neigh) {
-            if (!grid.at(n.x, n.y).visited) {
-                grid.removeWallBetween(current, n);
-                grid.at(n.x, n.y).visited = true;
-                st.push(n);
-                carved = true;
-                break;
+template <class Rng>
+void MazeGenerator::genKruskal(MazeGrid& grid, const MazeRect& region, Rng& rng, Workspace& ws) {
+    const int32_t rw = region.width, rh = region.height;
+    const int32_t n = rw * rh;
+    const size_t edgeCount = size_t(rw - 1) * rh + size_t(rw) * (rh - 1);
+    if (edgeCount == 0) { grid.setVisited(region.x, region.y); return; }
+
+    // Random edge order without a cache-hostile global Fisher-Yates: scatter the
+    // edges into random buckets that fit in cache, then shuffle each bucket
+    // (Rao-Sandelius). Two passes replay the same bucket draws, from their own
+    // engine, to size and fill the buckets.
+    const int bucketBits = edgeCount > (size_t(1) << 20) ? 12 : 4;
+    const uint32_t bucketMask = (1u << bucketBits) - 1;
+    std::vector<size_t>& bucketStart = ws.buckets;
+    std::vector<uint32_t>& edges = ws.edges;
+    bucketStart.assign((size_t(1) << bucketBits) + 1, 0);
+    edges.resize(edgeCount);
+    auto forEachEdge = [&](Rng draw, auto&& fn) {
+        uint64_t bits = 0; int left = 0;
+        for (int32_t y = 0; y < rh; ++y) {
+            for (int32_t x = 0; x < rw; ++x) {
+                // Candidate walls as 2*cell (east) or 2*cell+1 (south), in local indices
+                uint32_t i = uint32_t(y * rw + x);
+                for (uint32_t dir = 0; dir < 2; ++dir) {
+                    if (dir == 0 ? x + 1 >= rw : y + 1 >= rh) continue;
+                    if (left < bucketBits) { bits = draw(); left = 64; }
+                    fn(uint32_t(bits) & bucketMask, 2 * i + dir);
+                    bits >>= bucketBits; left -= bucketBits;
+                }
+            }
+        }
+    };
+    const Rng bucketRng(rng());
+    forEachEdge(bucketRng, [&](uint32_t b, uint32_t) { ++bucketStart[b + 1]; });
+    for (size_t b = 1; b < bucketStart.size(); ++b) bucketStart[b] += bucketStart[b - 1];
+    ws.fill.assign(bucketStart.begin(), bucketStart.end() - 1);
+    forEachEdge(bucketRng, [&](uint32_t b, uint32_t e) { edges[ws.fill[b]++] = e; });
+
+    DisjointSet& sets = ws.sets;
+    sets.reset(n);
+    auto cellsOf = [&](uint32_t e, int32_t& a, int32_t& b) {
+        a = int32_t(e >> 1);
+        b = (e & 1u) ? a + rw : a + 1;
+    };
+    const size_t lookahead = 16;
+    int32_t joined = 0;
+    for (size_t bucket = 0; bucket + 1 < bucketStart.size() && joined < n - 1; ++bucket) {
+        const size_t begin = bucketStart[bucket], end = bucketStart[bucket + 1];
+        for (size_t k = begin; k + 1 < end; ++k)
+            std::swap(edges[k], edges[k + randomBelow(rng, uint64_t(end - k))]);
+        for (size_t k = begin; k < end && joined < n - 1; ++k) {
+            int32_t a, b;
+            if (k + 2 * lookahead < end) {
+                cellsOf(edges[k + 2 * lookahead], a, b);
+                sets.prefetch(a);
+                sets.prefetch(b);
+            }
+            if (k + lookahead < end) {
+                cellsOf(edges[k + lookahead], a, b);
+                sets.prefetchParent(a);
+                sets.prefetchParent(b);
             }
+            cellsOf(edges[k], a, b);
+            if (!sets.unite(a, b)) continue;
+            ++joined;
+            grid.removeWallBetween({region.x + a % rw, region.y + a / rw}, {region.x + b % rw, region.y + b / rw});
         }
-        if (!carved) st.pop();
     }
+    for (int32_t y = 0; y < rh; ++y)
+        for (int32_t x = 0; x < rw; ++x) grid.setVisited(region.x + x, region.y + y);
+}
+
+template <class Rng>
+void MazeGenerator::genEller(MazeGrid& grid, const MazeRect& region, Rng& rng, Workspace& ws) {
+    ellerRows(region.width, region.height, rng, ws, [&](int y, const uint64_t* vWalls, const uint64_t* southWalls) {
+        int gy = region.y + y;
+        for (int x = 0; x < region.width; ++x) {
+            int gx = region.x + x;
+            if (x + 1 < region.width && !testBit(vWalls, x + 1)) grid.removeWallBetween({gx, gy}, {gx + 1, gy});
+            if (y + 1 < region.height && !testBit(southWalls, x)) grid.removeWallBetween({gx, gy}, {gx, gy + 1});
+            grid.setVisited(gx, gy);
+        }
+    });
 }
 
-void MazeGenerator::genPrims(MazeGrid& grid, std::mt19937_64& rng) {
-    std::uniform_int_distribution<int> distX(0, grid.width()-1);
-    std::uniform_int_distribution<int> distY(0, grid.height()-1);
-    Coord start{distX(rng), distY(rng)};
+template <class Rng, class Sink>
+void MazeGenerator::ellerRows(int width, int height, Rng& rng, Workspace& ws, Sink&& sink) {
+    const int W = width;
+    // Set labels live in [0, 2W): at most W are in use, so a fresh one always exists.
+    std::vector<int>& set = ws.set;
+    std::vector<int>& next = ws.next;
+    std::vector<int>& remaining = ws.remaining;
+    set.resize(size_t(W));
+    next.resize(size_t(W));
+    remaining.assign(2 * size_t(W), 0);
+    ws.hasDown.assign(2 * size_t(W), 0);
+    ws.used.assign(2 * size_t(W), 0);
+    ws.vRow.resize(MazeGrid::wordsForBits(size_t(W) + 1));
+    ws.sRow.resize(MazeGrid::wordsForBits(size_t(W)));
+    DisjointSet& sets = ws.sets;
+    for (int x = 0; x < W; ++x) set[x] = x;
 
-    std::vector<Neighbor> frontier;
-    grid.at(start.x, start.y).visited = true;
-    for (auto &n : neighbors4(grid, start)) frontier.push_back({n, start});
+    uint64_t bits = 0; int bitsLeft = 0;
+    auto coin = [&]() {
+        if (bitsLeft == 0) { bits = rng(); bitsLeft = 64; }
+        bool b = bits & 1u; bits >>= 1; --bitsLeft;
+        return b;
+    };
 
-    while (!frontier.empty()) {
-        std::uniform_int_distribution<size_t> pick(0, frontier.size()-1);
-        size_t idx = pick(rng);
-        Neighbor f = frontier[idx];
-        frontier.erase(frontier.begin() + idx);
+    for (int y = 0; y < height; ++y) {
+        const bool last = (y == height - 1);
+        fillRow(ws.vRow, size_t(W) + 1);
+        fillRow(ws.sRow, size_t(W));
+        sets.reset(2 * W);
 
-        if (grid.at(f.pos.x, f.pos.y).visited) continue;
-        grid.removeWallBetween(f.from, f.pos);
-        grid.at(f.pos.x, f.pos.y).visited = true;
-        for (auto &n : neighbors4(grid, f.pos)) {
-            if (!grid.at(n.x, n.y).visited) frontier.push_back({n, f.pos});
+        // Join adjacent cells of different sets; the last row joins all of them
+        for (int x = 0; x + 1 < W; ++x) {
+            if (sets.find(set[x]) != sets.find(set[x + 1]) && (last || coin())) {
+                clearBit(ws.vRow.data(), x + 1);
+                sets.unite(set[x], set[x + 1]);
+            }
+        }
+        for (int x = 0; x < W; ++x) set[x] = sets.find(set[x]);
+
+        if (!last) {
+            // Every set carries at least one cell down: the last member of a set
+            // is forced down if none of the earlier ones went.
+            for (int x = 0; x < W; ++x) remaining[set[x]]++;
+            for (int x = 0; x < W; ++x) {
+                int l = set[x];
+                bool down = coin();
+                if (--remaining[l] == 0 && !ws.hasDown[l]) down = true;
+                if (down) { clearBit(ws.sRow.data(), x); ws.hasDown[l] = 1; ws.used[l] = 1; next[x] = l; }
+                else next[x] = -1;
+            }
+            int fresh = 0;
+            for (int x = 0; x < W; ++x) {
+                if (next[x] >= 0) continue;
+                while (ws.used[fresh]) ++fresh;
+                next[x] = fresh;
+                ws.used[fresh] = 1;
+            }
+            for (int x = 0; x < W; ++x) { ws.hasDown[set[x]] = 0; ws.used[next[x]] = 0; }
+            set.swap(next);
         }
+        sink(y, static_cast<const uint64_t*>(ws.vRow.data()), static_cast<const uint64_t*>(ws.sRow.data()));
     }
 }
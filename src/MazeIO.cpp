@@ -1,107 +1,387 @@
 #include "MazeIO.h"
+#include "MazeCodec.h"
+#include "MazeGenerator.h"
 #include <QFile>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
+#include <QByteArray>
+#include <QtEndian>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <thread>
 
 namespace MazeIO {
 
-static bool parseJsonToGrid(std::unique_ptr<MazeGrid>& outGrid, MazeConfig& outCfg, const QJsonObject& root){
-    int w = root.value("width").toInt(0);
-    int h = root.value("height").toInt(0);
-    if (w <= 0 || h <= 0) return false;
-    outCfg.seed = static_cast<uint64_t>(root.value("seed").toDouble(0.0));
-    QString alg = root.value("algorithm").toString();
-    outCfg.algorithm = (alg == "Prims") ? MazeAlgorithm::Prims : MazeAlgorithm::RecursiveBacktracking;
-
-    QJsonArray cells = root.value("cells").toArray();
-    if (cells.size() != w*h) return false;
-
-    outGrid = std::make_unique<MazeGrid>(w,h);
-    int i=0;
-    for (int y=0; y<h; ++y){
-        for (int x=0; x<w; ++x){
-            QJsonObject co = cells[i++].toObject();
-            Cell &c = outGrid->at(x,y);
-            c.wallN = co.value("wallN").toBool(true);
-            c.wallE = co.value("wallE").toBool(true);
-            c.wallS = co.value("wallS").toBool(true);
-            c.wallW = co.value("wallW").toBool(true);
-            c.visited = true;
-        }
+// .mzb header, 64 bytes little-endian: 0 magic, 4 u32 version, 8 u32 width,
+// 12 u32 height, 16 u32 algorithm, 20 u32 rng, 24 u64 seed, 32 i32 threads,
+// 40 u64 horizontal plane offset, 48 u64 vertical plane offset, 56 reserved
+static const char kMzbMagic[4] = {'M', 'Z', 'B', 'F'};
+static const quint32 kMzbVersion = 1;
+static const qint64 kMzbHeaderSize = 64;
+
+// .mzc header, 48 bytes little-endian: 0 magic, 4 u32 version, 8 u32 width,
+// 12 u32 height, 16 u32 algorithm, 20 u32 rng, 24 u64 seed, 32 i32 threads,
+// 36 u32 generator version, 40 u32 mode, 44 reserved; the payload follows
+static const char kMzcMagic[4] = {'M', 'Z', 'C', 'F'};
+static const quint32 kMzcVersion = 1;
+static const qint64 kMzcHeaderSize = 48;
+enum MzcMode : quint32 { MzcReplay = 0, MzcCoded = 1 };
+
+QString algorithmName(MazeAlgorithm alg){
+    switch (alg) {
+        case MazeAlgorithm::Prims: return "Prims";
+        case MazeAlgorithm::Eller: return "Eller";
+        case MazeAlgorithm::Kruskal: return "Kruskal";
+        case MazeAlgorithm::RecursiveBacktracking: break;
+    }
+    return "RecursiveBacktracking";
+}
+
+MazeAlgorithm algorithmFromName(const QString& name){
+    if (name == "Prims") return MazeAlgorithm::Prims;
+    if (name == "Eller") return MazeAlgorithm::Eller;
+    if (name == "Kruskal") return MazeAlgorithm::Kruskal;
+    return MazeAlgorithm::RecursiveBacktracking;
+}
+
+QString rngName(MazeRng rng){
+    switch (rng) {
+        case MazeRng::Xoshiro256StarStar: return "Xoshiro256StarStar";
+        case MazeRng::Pcg64: return "Pcg64";
+        case MazeRng::Mt19937_64: break;
+    }
+    return "Mt19937_64";
+}
+
+MazeRng rngFromName(const QString& name){
+    if (name == "Xoshiro256StarStar") return MazeRng::Xoshiro256StarStar;
+    if (name == "Pcg64") return MazeRng::Pcg64;
+    return MazeRng::Mt19937_64;
+}
+
+bool loadCreate(std::unique_ptr<MazeGrid>& outGrid, MazeConfig& outCfg, const QString& filePath,
+                const ProgressFn& progress){
+    QFile f(filePath);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    const QByteArray magic = f.peek(4);
+    f.close();
+    if (magic == QByteArray(kMzbMagic, 4)) return loadBinary(outGrid, outCfg, filePath, progress);
+    if (magic == QByteArray(kMzcMagic, 4)) return loadCompact(outGrid, outCfg, filePath, progress);
+    if (magic == QByteArray("MZTF", 4)) // .mzt, see MazeIOTiled.cpp
+        return readRegion(filePath, MazeRect{0, 0, INT_MAX, INT_MAX}, outGrid, outCfg, 0, progress);
+    return loadJson(outGrid, outCfg, filePath, progress);
+}
+
+bool save(const MazeGrid& grid, const MazeConfig& cfg, const QString& filePath, const ProgressFn& progress){
+    if (filePath.endsWith(".mzb", Qt::CaseInsensitive)) return saveBinary(grid, cfg, filePath, progress);
+    if (filePath.endsWith(".mzc", Qt::CaseInsensitive)) return saveCompact(grid, cfg, filePath, progress);
+    if (filePath.endsWith(".mzt", Qt::CaseInsensitive)) return saveTiled(grid, cfg, filePath, 256, true, 0, progress);
+    return saveToJson(grid, cfg, filePath, JsonEncoding::Cells, progress);
+}
+
+bool readHeaderConfig(const uchar* d, const char* magic, quint32 version, MazeConfig& cfg){
+    if (std::memcmp(d, magic, 4) != 0 || qFromLittleEndian<quint32>(d + 4) != version) return false;
+    const quint32 w = qFromLittleEndian<quint32>(d + 8), h = qFromLittleEndian<quint32>(d + 12);
+    if (w == 0 || h == 0 || w >= quint32(INT_MAX) || h >= quint32(INT_MAX)) return false;
+    const quint32 alg = qFromLittleEndian<quint32>(d + 16), rng = qFromLittleEndian<quint32>(d + 20);
+    cfg.width = int(w);
+    cfg.height = int(h);
+    cfg.algorithm = alg <= quint32(MazeAlgorithm::Kruskal) ? MazeAlgorithm(alg) : MazeAlgorithm::RecursiveBacktracking;
+    cfg.rng = rng <= quint32(MazeRng::Pcg64) ? MazeRng(rng) : MazeRng::Mt19937_64;
+    cfg.seed = qFromLittleEndian<quint64>(d + 24);
+    cfg.threads = std::max(0, int(qFromLittleEndian<qint32>(d + 32)));
+    return true;
+}
+
+// The binary formats report once, when all bytes are written or read; false if canceled
+static bool reportDone(const ProgressFn& progress, qint64 bytes, const MazeGrid& grid){
+    if (!progress) return true;
+    const qint64 cells = qint64(grid.width()) * grid.height();
+    return progress(Progress{bytes, bytes, cells, cells});
+}
+
+struct MzbLayout {
+    quint64 hOffset = 0, vOffset = 0; // byte offsets of the planes
+    size_t hStride = 0, vStride = 0;  // words per row
+};
+
+// Checks that the words of a plane lie inside the file at an aligned offset
+static bool planeFits(quint64 offset, quint64 words, qint64 size){
+    const quint64 bytes = words * 8;
+    return offset % 8 == 0 && offset >= quint64(kMzbHeaderSize) &&
+           bytes <= quint64(size) && offset <= quint64(size) - bytes;
+}
+
+// Validates a .mzb image (header, plane bounds and zero row padding, the
+// invariant MazeGrid and the solvers rely on) and reads its header
+static bool parseMzb(const uchar* d, qint64 size, MazeConfig& cfg, MzbLayout& layout){
+    if (!d || size < kMzbHeaderSize || !readHeaderConfig(d, kMzbMagic, kMzbVersion, cfg)) return false;
+    const quint32 w = quint32(cfg.width), h = quint32(cfg.height);
+    layout.hOffset = qFromLittleEndian<quint64>(d + 40);
+    layout.vOffset = qFromLittleEndian<quint64>(d + 48);
+    layout.hStride = MazeGrid::wordsForBits(w);
+    layout.vStride = MazeGrid::wordsForBits(size_t(w) + 1);
+    if (!planeFits(layout.hOffset, quint64(layout.hStride) * (h + 1), size) ||
+        !planeFits(layout.vOffset, quint64(layout.vStride) * h, size)) return false;
+
+    const quint64 hPad = ~MazeGrid::tailMask(w), vPad = ~MazeGrid::tailMask(size_t(w) + 1);
+    for (quint64 r = 0; r <= h; ++r)
+        if (qFromLittleEndian<quint64>(d + layout.hOffset + ((r + 1) * layout.hStride - 1) * 8) & hPad) return false;
+    for (quint64 y = 0; y < h; ++y)
+        if (qFromLittleEndian<quint64>(d + layout.vOffset + ((y + 1) * layout.vStride - 1) * 8) & vPad) return false;
+    return true;
+}
+
+static bool writeWords(QFile& f, const std::vector<uint64_t>& words){
+    const qint64 bytes = qint64(words.size() * sizeof(uint64_t));
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    return f.write(reinterpret_cast<const char*>(words.data()), bytes) == bytes;
+#else
+    std::vector<uint64_t> le(words.size());
+    qToLittleEndian<quint64>(words.data(), qsizetype(words.size()), le.data());
+    return f.write(reinterpret_cast<const char*>(le.data()), bytes) == bytes;
+#endif
+}
+
+bool saveBinary(const MazeGrid& grid, const MazeConfig& cfg, const QString& filePath, const ProgressFn& progress){
+    const quint64 hBytes = quint64(grid.hWallWords().size()) * 8;
+    QByteArray header(int(kMzbHeaderSize), '\0');
+    uchar* d = reinterpret_cast<uchar*>(header.data());
+    std::memcpy(d, kMzbMagic, 4);
+    qToLittleEndian<quint32>(kMzbVersion, d + 4);
+    qToLittleEndian<quint32>(quint32(grid.width()), d + 8);
+    qToLittleEndian<quint32>(quint32(grid.height()), d + 12);
+    qToLittleEndian<quint32>(quint32(cfg.algorithm), d + 16);
+    qToLittleEndian<quint32>(quint32(cfg.rng), d + 20);
+    qToLittleEndian<quint64>(cfg.seed, d + 24);
+    qToLittleEndian<quint32>(quint32(cfg.threads), d + 32);
+    qToLittleEndian<quint64>(quint64(kMzbHeaderSize), d + 40);
+    qToLittleEndian<quint64>(quint64(kMzbHeaderSize) + hBytes, d + 48);
+
+    QFile f(filePath);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    bool ok = f.write(header) == header.size();
+    ok = ok && writeWords(f, grid.hWallWords()) && writeWords(f, grid.vWallWords());
+    ok = ok && reportDone(progress, f.pos(), grid);
+    f.close();
+    if (!ok) f.remove();
+    return ok;
+}
+
+bool loadBinary(std::unique_ptr<MazeGrid>& outGrid, MazeConfig& outCfg, const QString& filePath,
+                const ProgressFn& progress){
+    QFile f(filePath);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    qint64 size = f.size();
+    QByteArray buffer;
+    const uchar* d = size > 0 ? f.map(0, size) : nullptr;
+    if (!d){
+        buffer = f.readAll();
+        size = buffer.size();
+        d = reinterpret_cast<const uchar*>(buffer.constData());
     }
+    MazeConfig cfg{};
+    MzbLayout layout;
+    if (!parseMzb(d, size, cfg, layout)) return false;
+
+    auto grid = std::make_unique<MazeGrid>(cfg.width, cfg.height);
+    for (int r = 0; r <= cfg.height; ++r)
+        qFromLittleEndian<quint64>(d + layout.hOffset + quint64(r) * layout.hStride * 8,
+                                   qsizetype(layout.hStride), grid->hWallRow(r));
+    for (int y = 0; y < cfg.height; ++y)
+        qFromLittleEndian<quint64>(d + layout.vOffset + quint64(y) * layout.vStride * 8,
+                                   qsizetype(layout.vStride), grid->vWallRow(y));
+    if (!reportDone(progress, size, *grid)) return false;
+    grid->markAllVisited();
+    outGrid = std::move(grid);
+    outCfg = cfg;
     return true;
 }
 
-bool saveToJson(const MazeGrid& grid, const MazeConfig& cfg, const QString& filePath){
-    QJsonObject root;
-    root["width"] = grid.width();
-    root["height"] = grid.height();
-    root["seed"] = static_cast<double>(cfg.seed);
-    root["algorithm"] = (cfg.algorithm == MazeAlgorithm::RecursiveBacktracking) ? "RecursiveBacktracking" : "Prims";
-
-    QJsonArray cells;
-    for (int y=0; y<grid.height(); ++y){
-        for (int x=0; x<grid.width(); ++x){
-            const Cell& c = grid.at(x,y);
-            QJsonObject co;
-            co["wallN"] = c.wallN;
-            co["wallE"] = c.wallE;
-            co["wallS"] = c.wallS;
-            co["wallW"] = c.wallW;
-            cells.append(co);
+bool saveCompact(const MazeGrid& grid, const MazeConfig& cfg, const QString& filePath, const ProgressFn& progress){
+    // Pin the thread count: tiled generation depends on it
+    MazeConfig replay = cfg;
+    replay.width = grid.width();
+    replay.height = grid.height();
+    if (replay.threads <= 0) replay.threads = int(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::vector<uint8_t> payload;
+    quint32 mode = MzcCoded;
+    if (cfg.seed != 0){
+        MazeGrid base(replay.width, replay.height);
+        MazeGenerator::generate(base, replay);
+        payload = MazeCodec::encodeDiff(base, grid);
+        mode = MzcReplay;
+    }
+    // A single zero byte means "exactly the regenerated maze"; anything else
+    // may lose to coding the walls outright
+    if (mode != MzcReplay || payload.size() > 1){
+        std::vector<uint8_t> coded = MazeCodec::encodeWalls(grid);
+        if (mode != MzcReplay || coded.size() < payload.size()){
+            payload = std::move(coded);
+            mode = MzcCoded;
         }
     }
-    root["cells"] = cells;
 
-    QJsonDocument doc(root);
+    QByteArray header(int(kMzcHeaderSize), '\0');
+    uchar* d = reinterpret_cast<uchar*>(header.data());
+    std::memcpy(d, kMzcMagic, 4);
+    qToLittleEndian<quint32>(kMzcVersion, d + 4);
+    qToLittleEndian<quint32>(quint32(replay.width), d + 8);
+    qToLittleEndian<quint32>(quint32(replay.height), d + 12);
+    qToLittleEndian<quint32>(quint32(replay.algorithm), d + 16);
+    qToLittleEndian<quint32>(quint32(replay.rng), d + 20);
+    qToLittleEndian<quint64>(replay.seed, d + 24);
+    qToLittleEndian<quint32>(quint32(replay.threads), d + 32);
+    qToLittleEndian<quint32>(MazeGenerator::kVersion, d + 36);
+    qToLittleEndian<quint32>(mode, d + 40);
+
     QFile f(filePath);
     if (!f.open(QIODevice::WriteOnly)) return false;
-    f.write(doc.toJson(QJsonDocument::Indented));
+    const qint64 bytes = qint64(payload.size());
+    bool ok = f.write(header) == header.size();
+    ok = ok && f.write(reinterpret_cast<const char*>(payload.data()), bytes) == bytes;
+    ok = ok && reportDone(progress, f.pos(), grid);
     f.close();
-    return true;
+    if (!ok) f.remove();
+    return ok;
 }
 
-bool loadFromJson(MazeGrid& grid, MazeConfig& cfg, const QString& filePath){
+bool loadCompact(std::unique_ptr<MazeGrid>& outGrid, MazeConfig& outCfg, const QString& filePath,
+                 const ProgressFn& progress){
     QFile f(filePath);
     if (!f.open(QIODevice::ReadOnly)) return false;
-    QByteArray data = f.readAll();
+    const QByteArray data = f.readAll();
     f.close();
-    QJsonParseError err; QJsonDocument doc = QJsonDocument::fromJson(data, &err);
-    if (err.error != QJsonParseError::NoError || !doc.isObject()) return false;
-    QJsonObject root = doc.object();
-
-    std::unique_ptr<MazeGrid> tmp;
-    MazeConfig tmpCfg{};
-    if (!parseJsonToGrid(tmp, tmpCfg, root)) return false;
-    if (tmp->width() != grid.width() || tmp->height() != grid.height()) return false;
-
-    cfg = tmpCfg;
-    for (int y=0; y<grid.height(); ++y){
-        for (int x=0; x<grid.width(); ++x){
-            const Cell &src = tmp->at(x,y);
-            Cell &dst = grid.at(x,y);
-            dst.wallN = src.wallN; dst.wallE = src.wallE; dst.wallS = src.wallS; dst.wallW = src.wallW; dst.visited = true;
+    const uchar* d = reinterpret_cast<const uchar*>(data.constData());
+    MazeConfig cfg{};
+    if (data.size() < kMzcHeaderSize || !readHeaderConfig(d, kMzcMagic, kMzcVersion, cfg)) return false;
+    const quint32 generatorVersion = qFromLittleEndian<quint32>(d + 36);
+    const quint32 mode = qFromLittleEndian<quint32>(d + 40);
+    const uint8_t* payload = d + kMzcHeaderSize;
+    const size_t payloadSize = size_t(data.size() - kMzcHeaderSize);
+
+    // Size the grid only once the payload can hold it: a replay needs at least
+    // its diff count, coded walls a minimum per cell
+    if (mode == MzcReplay){
+        if (cfg.seed == 0 || cfg.threads == 0 || generatorVersion != MazeGenerator::kVersion || payloadSize < 1)
+            return false;
+    } else if (mode != MzcCoded ||
+               payloadSize < MazeCodec::minEncodedSize(quint64(cfg.width) * quint64(cfg.height))){
+        return false;
+    }
+
+    try {
+        auto grid = std::make_unique<MazeGrid>(cfg.width, cfg.height);
+        if (mode == MzcReplay){
+            MazeGenerator::generate(*grid, cfg);
+            if (!MazeCodec::applyDiff(payload, payloadSize, *grid)) return false;
+        } else if (!MazeCodec::decodeWalls(payload, payloadSize, *grid)){
+            return false;
         }
+        if (!reportDone(progress, data.size(), *grid)) return false;
+        grid->markAllVisited();
+        outGrid = std::move(grid);
+    } catch (const std::bad_alloc&) {
+        return false; // a replayed maze too large for memory
     }
+    outCfg = cfg;
     return true;
 }
 
-bool loadCreate(std::unique_ptr<MazeGrid>& outGrid, MazeConfig& outCfg, const QString& filePath){
+MappedMaze::MappedMaze() = default;
+MappedMaze::~MappedMaze() = default;
+
+bool MappedMaze::open(const QString& filePath){
+    close();
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    auto file = std::make_unique<QFile>(filePath);
+    if (!file->open(QIODevice::ReadOnly)) return false;
+    const qint64 size = file->size();
+    const uchar* d = size > 0 ? file->map(0, size) : nullptr;
+    MazeConfig cfg{};
+    MzbLayout layout;
+    if (!parseMzb(d, size, cfg, layout)) return false;
+    // Mappings are page aligned and the plane offsets are multiples of 8
+    view_ = MazeGridView(cfg.width, cfg.height,
+                         reinterpret_cast<const uint64_t*>(d + layout.hOffset),
+                         reinterpret_cast<const uint64_t*>(d + layout.vOffset));
+    cfg_ = cfg;
+    file_ = std::move(file);
+    return true;
+#else
+    Q_UNUSED(filePath);
+    return false;
+#endif
+}
+
+void MappedMaze::close(){
+    view_ = MazeGridView();
+    cfg_ = MazeConfig{};
+    file_.reset(); // unmaps
+}
+
+static bool writeFile(const QString& filePath, const QByteArray& data){
     QFile f(filePath);
-    if (!f.open(QIODevice::ReadOnly)) return false;
-    QByteArray data = f.readAll();
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    bool ok = f.write(data) == data.size();
     f.close();
-    QJsonParseError err; QJsonDocument doc = QJsonDocument::fromJson(data, &err);
-    if (err.error != QJsonParseError::NoError || !doc.isObject()) return false;
-    QJsonObject root = doc.object();
-    return parseJsonToGrid(outGrid, outCfg, root);
+    return ok;
 }
 
-bool saveSnapshotPNG(const QImage& image, const QString& filePath){
-    QImage img = image;
-    if (img.isNull()) return false;
-    return img.save(filePath, "PNG");
+bool saveAscii(const MazeGrid& grid, const QString& filePath){
+    const int W = grid.width(), H = grid.height();
+    QByteArray out;
+    out.reserve((3*W + 2) * (2*H + 1));
+    for (int y=0; y<=H; ++y){
+        // Edge row above cell row y (the bottom boundary when y == H)
+        out.append('+');
+        for (int x=0; x<W; ++x){
+            bool wall = y < H ? grid.wallN(x,y) : grid.wallS(x,H-1);
+            out.append(wall ? "--+" : "  +");
+        }
+        out.append('\n');
+        if (y == H) break;
+        for (int x=0; x<W; ++x) out.append(grid.wallW(x,y) ? "|  " : "   ");
+        out.append(grid.wallE(W-1,y) ? "|\n" : " \n");
+    }
+    return writeFile(filePath, out);
+}
+
+bool saveSvg(const MazeGrid& grid, const QString& filePath, int cellSize){
+    const int W = grid.width(), H = grid.height();
+    const int m = cellSize / 2;
+    QByteArray out;
+    out.append(QString("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%1\" height=\"%2\">\n"
+                       "<path stroke=\"black\" stroke-width=\"2\" stroke-linecap=\"square\" fill=\"none\" d=\"")
+                   .arg(W*cellSize + 2*m).arg(H*cellSize + 2*m).toUtf8());
+    // Consecutive walls along a row or column are merged into one segment
+    auto segment = [&](int x0, int y0, int x1, int y1){
+        out.append(QString("M%1 %2L%3 %4").arg(m + x0*cellSize).arg(m + y0*cellSize)
+                                          .arg(m + x1*cellSize).arg(m + y1*cellSize).toUtf8());
+    };
+    for (int r=0; r<=H; ++r){
+        int x=0;
+        while (x < W){
+            bool wall = r < H ? grid.wallN(x,r) : grid.wallS(x,H-1);
+            if (!wall){ ++x; continue; }
+            int x0 = x;
+            while (x < W && (r < H ? grid.wallN(x,r) : grid.wallS(x,H-1))) ++x;
+            segment(x0, r, x, r);
+        }
+    }
+    for (int c=0; c<=W; ++c){
+        int y=0;
+        while (y < H){
+            bool wall = c < W ? grid.wallW(c,y) : grid.wallE(W-1,y);
+            if (!wall){ ++y; continue; }
+            int y0 = y;
+            while (y < H && (c < W ? grid.wallW(c,y) : grid.wallE(W-1,y))) ++y;
+            segment(c, y0, c, y);
+        }
+    }
+    out.append("\"/>\n</svg>\n");
+    return writeFile(filePath, out);
 }
 
 } // namespace MazeIO
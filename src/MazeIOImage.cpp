@@ -0,0 +1,24 @@
+#include "MazeIO.h"
+#include <QImage>
+#include <limits>
+
+namespace MazeIO {
+
+bool saveSnapshotPNG(const QImage& image, const QString& filePath){
+    QImage img = image;
+    if (img.isNull()) return false;
+    return img.save(filePath, "PNG");
+}
+
+QImage renderImage(const MazeGrid& grid, const std::vector<Coord>& path, const MazeRaster::Style& style, int threads){
+    const int64_t w = MazeRaster::imageWidth(grid, style), h = MazeRaster::imageHeight(grid, style);
+    if (w > std::numeric_limits<int>::max() || h > std::numeric_limits<int>::max()) return {};
+    QImage img(int(w), int(h), QImage::Format_Indexed8);
+    if (img.isNull()) return {}; // too large for memory; use MazeRaster::savePNG
+    img.setColorTable({0xFF000000u | style.background, 0xFF000000u | style.wall, 0xFF000000u | style.path});
+    MazeRaster::render(grid, MazeRaster::PathCells(path, grid.width()), style,
+                       img.bits(), size_t(img.bytesPerLine()), threads);
+    return img;
+}
+
+} // namespace MazeIO
@@ -0,0 +1,58 @@
+#include "MazeIOJob.h"
+#include <QElapsedTimer>
+
+MazeIOJob::MazeIOJob(bool load, const QString& filePath, Work work, QObject* parent)
+    : QObject(parent), load_(load), path_(filePath), work_(std::move(work)) {}
+
+MazeIOJob::~MazeIOJob() {
+    cancel();
+    wait();
+}
+
+MazeIOJob* MazeIOJob::save(const MazeGrid& grid, const MazeConfig& cfg, const QString& filePath, QObject* parent) {
+    // The caller may edit or replace its grid while the copy is written
+    auto snapshot = std::make_shared<const MazeGrid>(grid);
+    return new MazeIOJob(false, filePath, [snapshot, cfg](MazeIOJob& job, const MazeIO::ProgressFn& progress) {
+        return MazeIO::save(*snapshot, cfg, job.path_, progress);
+    }, parent);
+}
+
+MazeIOJob* MazeIOJob::load(const QString& filePath, QObject* parent) {
+    return new MazeIOJob(true, filePath, [](MazeIOJob& job, const MazeIO::ProgressFn& progress) {
+        return MazeIO::loadCreate(job.grid_, job.cfg_, job.path_, progress);
+    }, parent);
+}
+
+void MazeIOJob::start() {
+    if (!work_) return; // already started
+    Work work = std::move(work_);
+    work_ = nullptr;
+    worker_ = std::thread([this, work = std::move(work)]() {
+        QElapsedTimer sinceReport;
+        sinceReport.start();
+        MazeIO::Progress last;
+        const MazeIO::ProgressFn progress = [&](const MazeIO::Progress& p) {
+            last = p;
+            if (sinceReport.elapsed() >= 50) {
+                sinceReport.restart();
+                emit this->progress(p.bytes, p.totalBytes, p.cells, p.totalCells);
+            }
+            return !canceled_;
+        };
+        // A failure the loaders did not anticipate, such as running out of
+        // memory, fails the job instead of terminating the application
+        try {
+            ok_ = !canceled_ && work(*this, progress) && !canceled_;
+        } catch (...) {
+            ok_ = false;
+        }
+        if (!ok_) grid_.reset();
+        if (ok_) emit this->progress(last.bytes, last.totalBytes, last.cells, last.totalCells);
+        emit finished(ok_);
+    });
+}
+
+bool MazeIOJob::wait() {
+    if (worker_.joinable()) worker_.join();
+    return ok_;
+}
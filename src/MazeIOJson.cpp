@@ -0,0 +1,426 @@
+// Streaming JSON persistence. The writer emits cells straight into a buffered
+// QFile; the reader is a small pull parser that fills the destination grid as
+// cells arrive, so neither side holds a DOM or the whole file in memory.
+#include "MazeIO.h"
+#include <QFile>
+#include <QByteArray>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace MazeIO {
+
+namespace {
+
+// Cell wall bits in the "cellMasks" encoding
+constexpr unsigned kMaskN = 1, kMaskE = 2, kMaskS = 4, kMaskW = 8;
+constexpr qsizetype kChunk = 1 << 16;
+
+// Reports progress after each chunk it writes; a failed write or a cancel
+// makes ok() false and drops everything appended afterwards
+class JsonWriter {
+public:
+    JsonWriter(QFile& f, const ProgressFn& progress, qint64 totalCells) : f_(f), progressFn_(progress) {
+        buf_.reserve(kChunk + 256);
+        progress_.totalCells = totalCells;
+    }
+    void append(const char* s) { buf_.append(s); flushIfFull(); }
+    void append(const QByteArray& s) { buf_.append(s); flushIfFull(); }
+    void setCells(qint64 cells) { progress_.cells = cells; }
+    bool ok() const { return ok_; }
+    bool finish() { flush(); return ok_; }
+
+private:
+    void flushIfFull() { if (buf_.size() >= kChunk) flush(); }
+    void flush() {
+        if (ok_ && !buf_.isEmpty()) {
+            ok_ = f_.write(buf_) == buf_.size();
+            progress_.bytes += buf_.size();
+            if (ok_ && progressFn_) ok_ = progressFn_(progress_);
+        }
+        buf_.clear();
+        buf_.reserve(kChunk + 256);
+    }
+    QFile& f_;
+    const ProgressFn& progressFn_;
+    Progress progress_;
+    QByteArray buf_;
+    bool ok_ = true;
+};
+
+unsigned cellMask(const MazeGrid& grid, int x, int y) {
+    return (grid.wallN(x,y) ? kMaskN : 0) | (grid.wallE(x,y) ? kMaskE : 0) |
+           (grid.wallS(x,y) ? kMaskS : 0) | (grid.wallW(x,y) ? kMaskW : 0);
+}
+
+QByteArray quoted(const QString& s) { return "\"" + s.toUtf8() + "\""; }
+
+// Pull parser over a buffered device. Only what maze files need: objects,
+// arrays, strings (escapes decoded for ASCII), numbers and literals.
+class JsonReader {
+public:
+    explicit JsonReader(QIODevice& dev) : dev_(dev) {}
+
+    // Bytes of the device parsed so far
+    qint64 consumed() const { return read_ - (len_ - pos_); }
+
+    // Skips whitespace; returns the next character without consuming it, 0 at the end
+    char peek() {
+        for (;;) {
+            if (pos_ == len_ && !fill()) return 0;
+            const char c = buf_[pos_];
+            if (c != ' ' && c != '\n' && c != '\r' && c != '\t') return c;
+            ++pos_;
+        }
+    }
+    bool consume(char c) {
+        if (peek() != c) return false;
+        ++pos_;
+        return true;
+    }
+
+    bool readString(std::string& out) {
+        out.clear();
+        if (!consume('"')) return false;
+        for (;;) {
+            if (pos_ == len_ && !fill()) return false;
+            // Copy plain runs in one go
+            qint64 end = pos_;
+            while (end < len_ && buf_[end] != '"' && buf_[end] != '\\') ++end;
+            out.append(buf_ + pos_, size_t(end - pos_));
+            pos_ = end;
+            if (pos_ == len_) continue;
+            char c = buf_[pos_++];
+            if (c == '"') return true;
+            // Escape
+            if (pos_ == len_ && !fill()) return false;
+            c = buf_[pos_++];
+            switch (c) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'u': {
+                    unsigned code = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        if (pos_ == len_ && !fill()) return false;
+                        const char h = buf_[pos_++];
+                        code = code * 16 + unsigned(h <= '9' ? h - '0' : (h | 0x20) - 'a' + 10);
+                    }
+                    c = code < 0x80 ? char(code) : '?';
+                    break;
+                }
+                default: break; // \" \\ \/
+            }
+            out.push_back(c);
+        }
+    }
+
+    bool readNumber(std::string& out) {
+        out.clear();
+        peek();
+        for (;;) {
+            if (pos_ == len_ && !fill()) break;
+            const char c = buf_[pos_];
+            if (!((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')) break;
+            out.push_back(c);
+            ++pos_;
+        }
+        return !out.empty();
+    }
+    bool readInt(long long& out) {
+        if (!readNumber(num_)) return false;
+        char* end = nullptr;
+        out = std::strtoll(num_.c_str(), &end, 10);
+        if (*end == '\0') return true;
+        out = static_cast<long long>(std::strtod(num_.c_str(), &end)); // written as a double
+        return *end == '\0';
+    }
+    bool readUInt64(uint64_t& out) {
+        if (!readNumber(num_)) return false;
+        char* end = nullptr;
+        out = std::strtoull(num_.c_str(), &end, 10);
+        if (*end == '\0') return true;
+        out = static_cast<uint64_t>(std::strtod(num_.c_str(), &end));
+        return *end == '\0';
+    }
+
+    // true/false; any other value is skipped and yields `fallback`
+    bool readBool(bool& out, bool fallback) {
+        const char c = peek();
+        if (c == 't' || c == 'f') return readLiteral(out);
+        out = fallback;
+        return skipValue();
+    }
+
+    bool skipValue() {
+        const char c = peek();
+        if (c == '"') return readString(skip_);
+        if (c == '{') return readObject([&](const std::string&) { return skipValue(); });
+        if (c == '[') return readArray([&]() { return skipValue(); });
+        if (c == 't' || c == 'f') { bool b; return readLiteral(b); }
+        if (c == 'n') return consumeWord("null");
+        return readNumber(skip_);
+    }
+
+    // Calls onKey(key) with the reader positioned at each member's value; the
+    // key string is reused, so it is only valid until the value is read
+    template <class F>
+    bool readObject(F&& onKey) {
+        if (!consume('{') || depth_ == kMaxDepth) return false;
+        ++depth_;
+        bool ok = consume('}');
+        if (!ok) {
+            do {
+                ok = readString(key_) && consume(':') && onKey(key_);
+            } while (ok && consume(','));
+            ok = ok && consume('}');
+        }
+        --depth_;
+        return ok;
+    }
+    template <class F>
+    bool readArray(F&& onElement) {
+        if (!consume('[') || depth_ == kMaxDepth) return false;
+        ++depth_;
+        bool ok = consume(']');
+        if (!ok) {
+            do {
+                ok = onElement();
+            } while (ok && consume(','));
+            ok = ok && consume(']');
+        }
+        --depth_;
+        return ok;
+    }
+
+private:
+    bool fill() {
+        if (eof_) return false;
+        len_ = dev_.read(buf_, sizeof buf_);
+        pos_ = 0;
+        if (len_ <= 0) { len_ = 0; eof_ = true; return false; }
+        read_ += len_;
+        return true;
+    }
+    bool consumeWord(const char* word) {
+        peek();
+        for (const char* w = word; *w; ++w) {
+            if (pos_ == len_ && !fill()) return false;
+            if (buf_[pos_++] != *w) return false;
+        }
+        return true;
+    }
+    bool readLiteral(bool& out) {
+        out = peek() == 't';
+        return consumeWord(out ? "true" : "false");
+    }
+
+    QIODevice& dev_;
+    char buf_[kChunk];
+    qint64 pos_ = 0, len_ = 0, read_ = 0;
+    bool eof_ = false;
+    std::string key_, num_, skip_;
+    // Objects and arrays nest at most this deep, as with QJsonDocument, so a
+    // hostile file fails to parse instead of overflowing the stack
+    static constexpr int kMaxDepth = 1024;
+    int depth_ = 0;
+};
+
+// Receives cells in row-major order. Once the size is known they go straight
+// into the grid; cells that arrive before "width"/"height" are kept as masks
+// until it is. Every cell takes at least two bytes ("0," in cellMasks), so a
+// size the file cannot hold is rejected before the grid is allocated.
+struct GridBuilder {
+    int width = 0, height = 0;
+    std::unique_ptr<MazeGrid> grid;
+    std::vector<uint8_t> pending;
+    size_t cells = 0;
+    size_t maxCells = 0;
+
+    bool sized() {
+        if (grid) return true;
+        const size_t total = size_t(width) * size_t(height);
+        if (width <= 0 || height <= 0 || total > maxCells || pending.size() > total) return false;
+        grid = std::make_unique<MazeGrid>(width, height);
+        for (size_t i = 0; i < pending.size(); ++i) apply(i, pending[i]);
+        pending = std::vector<uint8_t>();
+        return true;
+    }
+    void apply(size_t i, unsigned mask) {
+        const int x = int(i % size_t(width)), y = int(i / size_t(width));
+        auto c = grid->at(x, y);
+        c.wallN = (mask & kMaskN) != 0;
+        c.wallE = (mask & kMaskE) != 0;
+        c.wallS = (mask & kMaskS) != 0;
+        c.wallW = (mask & kMaskW) != 0;
+    }
+    bool add(unsigned mask) {
+        if (sized()) {
+            if (cells >= size_t(width) * size_t(height)) return false;
+            apply(cells, mask);
+        } else {
+            pending.push_back(uint8_t(mask));
+        }
+        ++cells;
+        return true;
+    }
+};
+
+bool parseMaze(QIODevice& dev, std::unique_ptr<MazeGrid>& outGrid, MazeConfig& outCfg,
+               const ProgressFn& progress) {
+    JsonReader r(dev);
+    GridBuilder b;
+    b.maxCells = size_t(std::max<qint64>(0, dev.size())) / 2;
+    auto report = [&]() {
+        const qint64 total = qint64(b.width) * b.height;
+        return !progress || progress(Progress{r.consumed(), dev.size(), qint64(b.cells), b.grid ? total : 0});
+    };
+    // Places a cell, reporting progress every kChunk cells
+    auto addCell = [&](unsigned mask) {
+        return b.add(mask) && (b.cells % size_t(kChunk) != 0 || report());
+    };
+    MazeConfig cfg{};
+    std::string text;
+    bool seenCells = false;
+    auto readSize = [&](int& v) {
+        long long n = 0;
+        if (!r.readInt(n) || n <= 0 || n > INT_MAX) return false;
+        if (b.grid && n != v) return false; // size changed after cells were placed
+        v = int(n);
+        return b.width == 0 || b.height == 0 || size_t(b.width) * size_t(b.height) <= b.maxCells;
+    };
+    const bool ok = r.readObject([&](const std::string& key) {
+        if (key == "width") return readSize(b.width);
+        if (key == "height") return readSize(b.height);
+        if (key == "seed") return r.readUInt64(cfg.seed);
+        if (key == "threads") {
+            long long n = 0;
+            if (!r.readInt(n)) return false;
+            cfg.threads = n < 0 || n > INT_MAX ? 1 : int(n);
+            return true;
+        }
+        if (key == "algorithm") {
+            if (!r.readString(text)) return false;
+            cfg.algorithm = algorithmFromName(QString::fromStdString(text));
+            return true;
+        }
+        if (key == "rng") {
+            if (!r.readString(text)) return false;
+            cfg.rng = rngFromName(QString::fromStdString(text));
+            return true;
+        }
+        if (key == "cells" && !seenCells) {
+            seenCells = true;
+            return r.readArray([&]() {
+                unsigned mask = 0, seen = 0;
+                bool ok = r.readObject([&](const std::string& wall) {
+                    bool v = true;
+                    if (!r.readBool(v, true)) return false;
+                    const unsigned bit = wall == "wallN" ? kMaskN : wall == "wallE" ? kMaskE
+                                       : wall == "wallS" ? kMaskS : wall == "wallW" ? kMaskW : 0;
+                    mask &= ~bit; // "visited" and unknown keys are ignored
+                    if (v) mask |= bit;
+                    seen |= bit;
+                    return true;
+                });
+                return ok && addCell(mask | ((kMaskN | kMaskE | kMaskS | kMaskW) & ~seen)); // missing walls default to up
+            });
+        }
+        if (key == "cellMasks" && !seenCells) {
+            seenCells = true;
+            return r.readArray([&]() {
+                long long m = 0;
+                return r.readInt(m) && m >= 0 && m <= 15 && addCell(unsigned(m));
+            });
+        }
+        return r.skipValue();
+    });
+    r.peek(); // trailing whitespace counts as read for the final report
+    if (!ok || !seenCells || !b.sized() || b.cells != size_t(b.width) * size_t(b.height) || !report()) return false;
+    b.grid->markAllVisited();
+    cfg.width = b.width;
+    cfg.height = b.height;
+    outGrid = std::move(b.grid);
+    outCfg = cfg;
+    return true;
+}
+
+}
+
+bool saveToJson(const MazeGrid& grid, const MazeConfig& cfg, const QString& filePath, JsonEncoding encoding,
+                const ProgressFn& progress){
+    QFile f(filePath);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    JsonWriter w(f, progress, qint64(grid.width()) * grid.height());
+    // Size first, so readers can place cells as they arrive
+    w.append("{\n    \"width\": " + QByteArray::number(grid.width()) +
+             ",\n    \"height\": " + QByteArray::number(grid.height()) +
+             ",\n    \"seed\": " + QByteArray::number(qulonglong(cfg.seed)) +
+             ",\n    \"algorithm\": " + quoted(algorithmName(cfg.algorithm)) +
+             ",\n    \"rng\": " + quoted(rngName(cfg.rng)) +
+             ",\n    \"threads\": " + QByteArray::number(cfg.threads) + ",\n");
+    const int W = grid.width(), H = grid.height();
+    if (encoding == JsonEncoding::Bitmask) {
+        // One row of cells per line
+        w.append("    \"cellMasks\": [\n");
+        QByteArray line;
+        for (int y=0; y<H && w.ok(); ++y){
+            line = "        ";
+            for (int x=0; x<W; ++x){
+                const unsigned m = cellMask(grid, x, y);
+                if (m >= 10) line.append('1');
+                line.append(char('0' + m % 10));
+                if (x + 1 < W) line.append(',');
+            }
+            line.append(y + 1 < H ? ",\n" : "\n");
+            w.setCells(qint64(y + 1) * W);
+            w.append(line);
+        }
+    } else {
+        // Only 16 distinct cell objects exist; format each once
+        static const char* const kBool[2] = {"false", "true"};
+        QByteArray lines[16];
+        for (unsigned m = 0; m < 16; ++m)
+            lines[m] = QByteArray("        {\"wallN\": ") + kBool[(m & kMaskN) != 0] +
+                       ", \"wallE\": " + kBool[(m & kMaskE) != 0] +
+                       ", \"wallS\": " + kBool[(m & kMaskS) != 0] +
+                       ", \"wallW\": " + kBool[(m & kMaskW) != 0] + "}";
+        w.append("    \"cells\": [\n");
+        for (int y=0; y<H && w.ok(); ++y){
+            w.setCells(qint64(y) * W);
+            for (int x=0; x<W; ++x){
+                w.append(lines[cellMask(grid, x, y)]);
+                w.append(x + 1 < W || y + 1 < H ? ",\n" : "\n");
+            }
+        }
+        w.setCells(qint64(W) * H);
+    }
+    w.append("    ]\n}\n");
+    const bool ok = w.finish();
+    f.close();
+    if (!ok) f.remove();
+    return ok;
+}
+
+bool loadJson(std::unique_ptr<MazeGrid>& outGrid, MazeConfig& outCfg, const QString& filePath,
+              const ProgressFn& progress){
+    QFile f(filePath);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    return parseMaze(f, outGrid, outCfg, progress);
+}
+
+bool loadFromJson(MazeGrid& grid, MazeConfig& cfg, const QString& filePath){
+    std::unique_ptr<MazeGrid> tmp;
+    MazeConfig tmpCfg{};
+    if (!loadJson(tmp, tmpCfg, filePath)) return false;
+    if (tmp->width() != grid.width() || tmp->height() != grid.height()) return false;
+    cfg = tmpCfg;
+    grid = std::move(*tmp);
+    return true;
+}
+
+}
@@ -0,0 +1,261 @@
+// Tiled persistence. The maze is cut into square tiles stored as standalone
+// grids behind an index, so reading a region seeks to and decodes only the
+// tiles it overlaps, and tiles encode and decode independently in parallel.
+#include "MazeIO.h"
+#include "MazeCodec.h"
+#include "MazeParallel.h"
+#include <QFile>
+#include <QByteArray>
+#include <QtEndian>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace MazeIO {
+
+namespace {
+
+// .mzt header, 64 bytes little-endian: 0 magic, 4 u32 version, 8 u32 width,
+// 12 u32 height, 16 u32 algorithm, 20 u32 rng, 24 u64 seed, 32 i32 threads,
+// 36 u32 tile size, 40 u32 tile columns, 44 u32 tile rows, 48 u64 index
+// offset, 56 reserved. Index entries: u64 offset, u32 size, u32 encoding.
+constexpr char kMztMagic[4] = {'M', 'Z', 'T', 'F'};
+constexpr quint32 kMztVersion = 1;
+constexpr qint64 kMztHeaderSize = 64;
+constexpr qint64 kIndexEntrySize = 16;
+enum TileEncoding : quint32 { TileRaw = 0, TileCoded = 1 };
+
+struct MztHeader {
+    MazeConfig cfg{};
+    int tileSize = 0, tilesX = 0, tilesY = 0;
+    quint64 indexOffset = 0;
+};
+
+struct Tile {
+    QByteArray data;
+    quint32 encoding = TileRaw;
+};
+
+// Bits [bit, bit+n) of a bit row, n in 1..64
+uint64_t loadBits(const uint64_t* src, size_t bit, size_t n) {
+    const size_t w = bit >> 6, s = bit & 63;
+    uint64_t v = src[w] >> s;
+    if (s != 0 && s + n > 64) v |= src[w + 1] << (64 - s);
+    return n == 64 ? v : v & ((uint64_t(1) << n) - 1);
+}
+
+void storeBits(uint64_t* dst, size_t bit, size_t n, uint64_t v) {
+    const size_t w = bit >> 6, s = bit & 63;
+    const uint64_t mask = n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+    dst[w] = (dst[w] & ~(mask << s)) | (v << s);
+    if (s != 0 && s + n > 64) {
+        const uint64_t high = (uint64_t(1) << (s + n - 64)) - 1;
+        dst[w + 1] = (dst[w + 1] & ~high) | (v >> (64 - s));
+    }
+}
+
+void copyBits(uint64_t* dst, size_t dstBit, const uint64_t* src, size_t srcBit, size_t n) {
+    for (size_t done = 0; done < n; done += 64) {
+        const size_t k = std::min<size_t>(64, n - done);
+        storeBits(dst, dstBit + done, k, loadBits(src, srcBit + done, k));
+    }
+}
+
+// Copies the walls of the w x h cells at (sx, sy) of src, outer edges
+// included, onto the cells at (dx, dy) of dst
+void copyWalls(const MazeGrid& src, int sx, int sy, MazeGrid& dst, int dx, int dy, int w, int h) {
+    for (int r = 0; r <= h; ++r)
+        copyBits(dst.hWallRow(dy + r), size_t(dx), src.hWallRow(sy + r), size_t(sx), size_t(w));
+    for (int y = 0; y < h; ++y)
+        copyBits(dst.vWallRow(dy + y), size_t(dx), src.vWallRow(sy + y), size_t(sx), size_t(w) + 1);
+}
+
+qint64 rawTileBytes(const MazeGrid& tile) {
+    return qint64(tile.hWallWords().size() + tile.vWallWords().size()) * 8;
+}
+
+Tile encodeTile(const MazeGrid& grid, int x0, int y0, int w, int h, bool compress) {
+    MazeGrid tile(w, h);
+    copyWalls(grid, x0, y0, tile, 0, 0, w, h);
+    Tile t;
+    if (compress) {
+        const std::vector<uint8_t> coded = MazeCodec::encodeWalls(tile);
+        // Noise-like walls can code larger than the raw planes
+        if (qint64(coded.size()) < rawTileBytes(tile)) {
+            t.data = QByteArray(reinterpret_cast<const char*>(coded.data()), qsizetype(coded.size()));
+            t.encoding = TileCoded;
+            return t;
+        }
+    }
+    t.data.resize(qsizetype(rawTileBytes(tile)));
+    uchar* d = reinterpret_cast<uchar*>(t.data.data());
+    for (const std::vector<uint64_t>* plane : {&tile.hWallWords(), &tile.vWallWords()}) {
+        qToLittleEndian<quint64>(plane->data(), qsizetype(plane->size()), d);
+        d += plane->size() * 8;
+    }
+    return t;
+}
+
+bool decodeTile(const Tile& t, MazeGrid& tile) {
+    const uchar* d = reinterpret_cast<const uchar*>(t.data.constData());
+    if (t.encoding == TileCoded) return MazeCodec::decodeWalls(d, size_t(t.data.size()), tile);
+    if (t.encoding != TileRaw || t.data.size() != rawTileBytes(tile)) return false;
+    for (int r = 0; r <= tile.height(); ++r, d += tile.hWordsPerRow() * 8)
+        qFromLittleEndian<quint64>(d, qsizetype(tile.hWordsPerRow()), tile.hWallRow(r));
+    for (int y = 0; y < tile.height(); ++y, d += tile.vWordsPerRow() * 8)
+        qFromLittleEndian<quint64>(d, qsizetype(tile.vWordsPerRow()), tile.vWallRow(y));
+    return true;
+}
+
+bool readHeader(QFile& f, MztHeader& hdr) {
+    const QByteArray header = f.read(kMztHeaderSize);
+    const uchar* d = reinterpret_cast<const uchar*>(header.constData());
+    if (header.size() != kMztHeaderSize || !readHeaderConfig(d, kMztMagic, kMztVersion, hdr.cfg)) return false;
+    const quint32 w = quint32(hdr.cfg.width), h = quint32(hdr.cfg.height);
+    const quint32 ts = qFromLittleEndian<quint32>(d + 36);
+    if (ts == 0 || ts >= quint32(INT_MAX)) return false;
+    hdr.tileSize = int(ts);
+    hdr.tilesX = int((w - 1) / ts + 1);
+    hdr.tilesY = int((h - 1) / ts + 1);
+    hdr.indexOffset = qFromLittleEndian<quint64>(d + 48);
+    const quint64 indexBytes = quint64(hdr.tilesX) * quint64(hdr.tilesY) * kIndexEntrySize;
+    // Every tile takes at least as many bytes as coding it could produce, so
+    // the file bounds the size of the maze before anything is allocated
+    const quint64 minTileBytes = MazeCodec::minEncodedSize(quint64(w) * h);
+    return qFromLittleEndian<quint32>(d + 40) == quint32(hdr.tilesX) &&
+           qFromLittleEndian<quint32>(d + 44) == quint32(hdr.tilesY) &&
+           hdr.indexOffset >= quint64(kMztHeaderSize) && indexBytes <= quint64(f.size()) &&
+           hdr.indexOffset <= quint64(f.size()) - indexBytes &&
+           minTileBytes <= quint64(f.size()) - kMztHeaderSize - indexBytes;
+}
+
+}
+
+bool saveTiled(const MazeGrid& grid, const MazeConfig& cfg, const QString& filePath,
+               int tileSize, bool compress, int threads, const ProgressFn& progress){
+    if (tileSize <= 0) return false;
+    const int W = grid.width(), H = grid.height();
+    const int tilesX = (W - 1) / tileSize + 1, tilesY = (H - 1) / tileSize + 1;
+    const qint64 indexBytes = qint64(tilesX) * tilesY * kIndexEntrySize;
+
+    QByteArray header(int(kMztHeaderSize), '\0');
+    uchar* d = reinterpret_cast<uchar*>(header.data());
+    std::memcpy(d, kMztMagic, 4);
+    qToLittleEndian<quint32>(kMztVersion, d + 4);
+    qToLittleEndian<quint32>(quint32(W), d + 8);
+    qToLittleEndian<quint32>(quint32(H), d + 12);
+    qToLittleEndian<quint32>(quint32(cfg.algorithm), d + 16);
+    qToLittleEndian<quint32>(quint32(cfg.rng), d + 20);
+    qToLittleEndian<quint64>(cfg.seed, d + 24);
+    qToLittleEndian<quint32>(quint32(cfg.threads), d + 32);
+    qToLittleEndian<quint32>(quint32(tileSize), d + 36);
+    qToLittleEndian<quint32>(quint32(tilesX), d + 40);
+    qToLittleEndian<quint32>(quint32(tilesY), d + 44);
+    qToLittleEndian<quint64>(quint64(kMztHeaderSize), d + 48);
+
+    QFile f(filePath);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    // The index is filled in once the tile sizes are known
+    QByteArray index(qsizetype(indexBytes), '\0');
+    bool ok = f.write(header) == header.size() && f.write(index) == index.size();
+    qint64 offset = kMztHeaderSize + indexBytes;
+    std::vector<Tile> row(static_cast<size_t>(tilesX));
+    for (int ty = 0; ty < tilesY && ok; ++ty) {
+        const int y0 = ty * tileSize, h = std::min(tileSize, H - y0);
+        parallelFor(row.size(), threads, [&](size_t tx) {
+            const int x0 = int(tx) * tileSize;
+            row[tx] = encodeTile(grid, x0, y0, std::min(tileSize, W - x0), h, compress);
+        });
+        for (int tx = 0; tx < tilesX && ok; ++tx) {
+            const Tile& t = row[size_t(tx)];
+            uchar* e = reinterpret_cast<uchar*>(index.data()) + (qint64(ty) * tilesX + tx) * kIndexEntrySize;
+            qToLittleEndian<quint64>(quint64(offset), e);
+            qToLittleEndian<quint32>(quint32(t.data.size()), e + 8);
+            qToLittleEndian<quint32>(t.encoding, e + 12);
+            ok = f.write(t.data) == t.data.size();
+            offset += t.data.size();
+        }
+        if (ok && progress)
+            ok = progress(Progress{offset, 0, qint64(y0 + h) * W, qint64(W) * H});
+    }
+    ok = ok && f.seek(kMztHeaderSize) && f.write(index) == index.size();
+    f.close();
+    if (!ok) f.remove();
+    return ok;
+}
+
+bool readRegion(const QString& filePath, const MazeRect& region, std::unique_ptr<MazeGrid>& outGrid,
+                MazeConfig& outCfg, int threads, const ProgressFn& progress){
+    QFile f(filePath);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    MztHeader hdr;
+    if (!readHeader(f, hdr)) return false;
+    const int W = hdr.cfg.width, H = hdr.cfg.height, ts = hdr.tileSize;
+    const int x0 = std::max(0, region.x), y0 = std::max(0, region.y);
+    const int x1 = int(std::min<qint64>(W, qint64(region.x) + region.width));
+    const int y1 = int(std::min<qint64>(H, qint64(region.y) + region.height));
+    if (x0 >= x1 || y0 >= y1) return false;
+
+    std::unique_ptr<MazeGrid> grid;
+    try {
+        grid = std::make_unique<MazeGrid>(x1 - x0, y1 - y0);
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+    const int tx0 = x0 / ts, tx1 = (x1 - 1) / ts, ty0 = y0 / ts, ty1 = (y1 - 1) / ts;
+    const size_t cols = size_t(tx1 - tx0 + 1);
+    const qint64 fileSize = f.size();
+    const qint64 regionCells = qint64(x1 - x0) * (y1 - y0);
+    std::vector<Tile> row(cols);
+    std::vector<std::unique_ptr<MazeGrid>> tiles(cols);
+    std::vector<char> decoded(cols);
+    qint64 bytesRead = 0;
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        // Index entries of this tile row, then the payloads
+        if (!f.seek(qint64(hdr.indexOffset) + (qint64(ty) * hdr.tilesX + tx0) * kIndexEntrySize)) return false;
+        const QByteArray entries = f.read(qint64(cols) * kIndexEntrySize);
+        if (entries.size() != qint64(cols) * kIndexEntrySize) return false;
+        for (size_t i = 0; i < cols; ++i) {
+            const uchar* e = reinterpret_cast<const uchar*>(entries.constData()) + i * kIndexEntrySize;
+            const quint64 offset = qFromLittleEndian<quint64>(e);
+            const quint32 size = qFromLittleEndian<quint32>(e + 8);
+            if (size > quint64(fileSize) || offset > quint64(fileSize) - size || !f.seek(qint64(offset))) return false;
+            row[i].data = f.read(qint64(size));
+            row[i].encoding = qFromLittleEndian<quint32>(e + 12);
+            if (row[i].data.size() != qint64(size)) return false;
+            bytesRead += size;
+        }
+        const int tileY = ty * ts, th = std::min(ts, H - tileY);
+        parallelFor(cols, threads, [&](size_t i) {
+            const int tileX = (tx0 + int(i)) * ts, tw = std::min(ts, W - tileX);
+            // A coded tile too short for its cells would be walked in full
+            // on zero bytes; reject it before sizing the tile
+            decoded[i] = row[i].encoding != TileCoded ||
+                         quint64(row[i].data.size()) >= MazeCodec::minEncodedSize(quint64(tw) * quint64(th));
+            if (!decoded[i]) return;
+            try {
+                tiles[i] = std::make_unique<MazeGrid>(tw, th);
+                decoded[i] = decodeTile(row[i], *tiles[i]);
+            } catch (const std::bad_alloc&) {
+                decoded[i] = false;
+            }
+        });
+        const int iy0 = std::max(y0, tileY), iy1 = std::min(y1, tileY + th);
+        for (size_t i = 0; i < cols; ++i) {
+            if (!decoded[i]) return false;
+            const int tileX = (tx0 + int(i)) * ts;
+            const int ix0 = std::max(x0, tileX), ix1 = std::min(x1, tileX + tiles[i]->width());
+            copyWalls(*tiles[i], ix0 - tileX, iy0 - tileY, *grid, ix0 - x0, iy0 - y0, ix1 - ix0, iy1 - iy0);
+        }
+        if (progress && !progress(Progress{bytesRead, 0, qint64(iy1 - y0) * (x1 - x0), regionCells})) return false;
+    }
+    grid->markAllVisited();
+    outGrid = std::move(grid);
+    outCfg = hdr.cfg;
+    return true;
+}
+
+} // namespace MazeIO
@@ -0,0 +1,171 @@
+#include "MazeIncrementalSolver.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+template <class F>
+inline void forEachOpen(const MazeGrid& grid, int32_t i, F&& f) {
+    const int W = grid.width();
+    const int x = i % W, y = i / W;
+    if (y > 0 && !grid.wallN(x,y)) f(i - W);
+    if (x + 1 < W && !grid.wallE(x,y)) f(i + 1);
+    if (y + 1 < grid.height() && !grid.wallS(x,y)) f(i + W);
+    if (x > 0 && !grid.wallW(x,y)) f(i - 1);
+}
+
+}
+
+void MazeIncrementalSolver::reset(const MazeGrid& grid, Coord start, Coord goal) {
+    grid_ = &grid;
+    start_ = start;
+    goal_ = goal;
+    const size_t n = size_t(grid.width()) * size_t(grid.height());
+    g_.assign(n, kInf);
+    rhs_.assign(n, kInf);
+    heapPos_.assign(n, -1);
+    heap_.clear();
+    if (!grid.inBounds(start.x, start.y) || !grid.inBounds(goal.x, goal.y)) return;
+    src_ = start.y * grid.width() + start.x;
+    dst_ = goal.y * grid.width() + goal.x;
+    rhs_[size_t(src_)] = 0;
+    heapPush(src_, key(src_));
+}
+
+uint32_t MazeIncrementalSolver::heuristic(int32_t i) const {
+    const int W = grid_->width();
+    return uint32_t(std::abs(i % W - goal_.x) + std::abs(i / W - goal_.y));
+}
+
+// (min(g, rhs) + h, min(g, rhs)) packed so one comparison orders both parts;
+// cells no search has reached sort after everything else
+uint64_t MazeIncrementalSolver::key(int32_t i) const {
+    const uint32_t m = std::min(g_[size_t(i)], rhs_[size_t(i)]);
+    if (m == kInf) return UINT64_MAX;
+    return (uint64_t(m + heuristic(i)) << 32) | m;
+}
+
+void MazeIncrementalSolver::updateCell(int32_t i) {
+    if (i != src_) {
+        uint32_t best = kInf;
+        forEachOpen(*grid_, i, [&](int32_t n) {
+            if (g_[size_t(n)] != kInf) best = std::min(best, g_[size_t(n)] + 1);
+        });
+        rhs_[size_t(i)] = best;
+    }
+    const int32_t pos = heapPos_[size_t(i)];
+    if (g_[size_t(i)] == rhs_[size_t(i)]) {
+        if (pos >= 0) heapRemove(i);
+    } else if (pos < 0) {
+        heapPush(i, key(i));
+    } else {
+        heap_[size_t(pos)].key = key(i);
+        heapUp(size_t(pos));
+        heapDown(size_t(heapPos_[size_t(i)]));
+    }
+}
+
+void MazeIncrementalSolver::wallChanged(Coord a, Coord b) {
+    if (!grid_ || heapPos_.empty()) return;
+    const int W = grid_->width();
+    if (grid_->inBounds(a.x, a.y)) updateCell(a.y * W + a.x);
+    if (grid_->inBounds(b.x, b.y)) updateCell(b.y * W + b.x);
+}
+
+void MazeIncrementalSolver::computeShortestPath(SolveStats* stats) {
+    uint64_t explored = 0;
+    while (!heap_.empty() && (heap_[0].key < key(dst_) || rhs_[size_t(dst_)] != g_[size_t(dst_)])) {
+        const int32_t u = heap_[0].cell;
+        heapRemove(u);
+        ++explored;
+        if (g_[size_t(u)] > rhs_[size_t(u)]) {
+            // Overconsistent: the distance dropped, settle it and relax the neighbors
+            g_[size_t(u)] = rhs_[size_t(u)];
+            forEachOpen(*grid_, u, [&](int32_t n) { updateCell(n); });
+        } else {
+            // Underconsistent: the old distance is gone, re-derive this cell and
+            // everything that may have depended on it
+            g_[size_t(u)] = kInf;
+            updateCell(u);
+            forEachOpen(*grid_, u, [&](int32_t n) { updateCell(n); });
+        }
+    }
+    if (stats) stats->explored = explored;
+}
+
+std::optional<MazePath> MazeIncrementalSolver::solve(SolveStats* stats) {
+    if (stats) *stats = SolveStats{};
+    if (!grid_ || heapPos_.empty() ||
+        !grid_->inBounds(start_.x, start_.y) || !grid_->inBounds(goal_.x, goal_.y)) return std::nullopt;
+    computeShortestPath(stats);
+    if (g_[size_t(dst_)] == kInf) return std::nullopt;
+
+    // Walk back from the goal, always to the neighbor closest to the start; on
+    // the settled path that is exactly one step closer each time
+    const int W = grid_->width();
+    MazePath path;
+    path.nodes.resize(size_t(g_[size_t(dst_)]) + 1);
+    int32_t cur = dst_;
+    for (size_t k = path.nodes.size() - 1; k > 0; --k) {
+        path.nodes[k] = Coord{cur % W, cur / W};
+        int32_t prev = -1;
+        forEachOpen(*grid_, cur, [&](int32_t n) {
+            if (prev < 0 || g_[size_t(n)] < g_[size_t(prev)]) prev = n;
+        });
+        if (prev < 0 || g_[size_t(prev)] != uint32_t(k - 1)) return std::nullopt;
+        cur = prev;
+    }
+    path.nodes[0] = start_;
+    return path;
+}
+
+uint32_t MazeIncrementalSolver::distance() const {
+    return heapPos_.empty() ? kInf : g_[size_t(dst_)];
+}
+
+void MazeIncrementalSolver::heapPush(int32_t i, uint64_t k) {
+    heapPos_[size_t(i)] = int32_t(heap_.size());
+    heap_.push_back(HeapEntry{k, i});
+    heapUp(heap_.size() - 1);
+}
+
+void MazeIncrementalSolver::heapRemove(int32_t i) {
+    const size_t pos = size_t(heapPos_[size_t(i)]);
+    heapPos_[size_t(i)] = -1;
+    const HeapEntry last = heap_.back();
+    heap_.pop_back();
+    if (pos == heap_.size()) return;
+    heap_[pos] = last;
+    heapPos_[size_t(last.cell)] = int32_t(pos);
+    heapUp(pos);
+    heapDown(size_t(heapPos_[size_t(last.cell)]));
+}
+
+void MazeIncrementalSolver::heapUp(size_t pos) {
+    const HeapEntry e = heap_[pos];
+    while (pos > 0) {
+        const size_t parent = (pos - 1) / 2;
+        if (heap_[parent].key <= e.key) break;
+        heap_[pos] = heap_[parent];
+        heapPos_[size_t(heap_[pos].cell)] = int32_t(pos);
+        pos = parent;
+    }
+    heap_[pos] = e;
+    heapPos_[size_t(e.cell)] = int32_t(pos);
+}
+
+void MazeIncrementalSolver::heapDown(size_t pos) {
+    const HeapEntry e = heap_[pos];
+    const size_t n = heap_.size();
+    for (;;) {
+        size_t child = 2 * pos + 1;
+        if (child >= n) break;
+        if (child + 1 < n && heap_[child + 1].key < heap_[child].key) ++child;
+        if (e.key <= heap_[child].key) break;
+        heap_[pos] = heap_[child];
+        heapPos_[size_t(heap_[pos].cell)] = int32_t(pos);
+        pos = child;
+    }
+    heap_[pos] = e;
+    heapPos_[size_t(e.cell)] = int32_t(pos);
+}
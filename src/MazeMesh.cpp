@@ -0,0 +1,179 @@
+#include "MazeMesh.h"
+#include "MazeBits.h"
+#include <algorithm>
+
+namespace {
+using namespace MazeMesh;
+
+struct Q3 { int x, y, z; }; // quantized, chunk-relative
+
+// Starts a chunk at the end of the mesh; quads are appended to the last chunk
+void beginChunk(Mesh& out, int originX, int originZ) {
+    Chunk c;
+    c.originX = originX;
+    c.originZ = originZ;
+    c.cellsX = kChunkCells;
+    c.cellsZ = kChunkCells;
+    c.firstVertex = uint32_t(out.vertices.size());
+    c.firstIndex = uint32_t(out.indices.size());
+    c.firstWall = uint32_t(out.walls.size());
+    out.chunks.push_back(c);
+}
+
+// Corners a, b, c, d go counter-clockwise seen from the side `n` points to, so
+// the quad is front-facing for GL_CULL_FACE
+void addQuad(Mesh& out, const Q3& a, const Q3& b, const Q3& c, const Q3& d, Normal n, Material m) {
+    Chunk& chunk = out.chunks.back();
+    const uint16_t base = uint16_t(chunk.vertexCount);
+    for (const Q3& p : {a, b, c, d})
+        out.vertices.push_back(MazeVertex{{uint16_t(p.x), uint16_t(p.y), uint16_t(p.z)}, n, m});
+    for (int i : {0, 1, 2, 0, 2, 3}) out.indices.push_back(uint16_t(base + i));
+    chunk.vertexCount += 4;
+    chunk.indexCount += 6;
+}
+
+// `count` (<= 64) bits of a bitplane row starting at bit `first`
+uint64_t bitsAt(const uint64_t* row, size_t first, int count) {
+    const size_t k = first / 64;
+    const unsigned shift = unsigned(first % 64);
+    uint64_t v = row[k] >> shift;
+    if (shift && shift + unsigned(count) > 64) v |= row[k + 1] << (64 - shift);
+    return count < 64 ? v & ((uint64_t(1) << count) - 1) : v;
+}
+
+// Calls f(begin, end) for each run of set bits in v
+template <class F>
+void forEachRun(uint64_t v, F&& f) {
+    int at = 0;
+    while (v >> at) {
+        at += lowestBit(v >> at);
+        const uint64_t gaps = ~v >> at;
+        const int end = gaps ? at + lowestBit(gaps) : 64;
+        f(at, end);
+        if (end == 64) break;
+        at = end;
+    }
+}
+
+// Fills the chunk's wall slots from the grid. A chunk owns the walls on its
+// north and west edges, and the maze's south and east boundary where it
+// reaches them.
+void buildWalls(const MazeGridView& grid, Mesh& out, Chunk& chunk) {
+    const int W = grid.width(), H = grid.height();
+    const int x0 = chunk.originX, z0 = chunk.originZ;
+    const int cw = std::min(kChunkCells, W - x0), ch = std::min(kChunkCells, H - z0);
+    MazeWallInstance* walls = out.walls.data() + chunk.firstWall;
+    uint32_t count = 0;
+    auto addWall = [&](int x, int z, int length, Axis axis) {
+        walls[count++] = MazeWallInstance{uint8_t(x), uint8_t(z), uint8_t(length), axis};
+    };
+
+    const int rows = ch + (z0 + ch == H ? 1 : 0);
+    for (int r = 0; r < rows; ++r)
+        forEachRun(bitsAt(grid.hWallRow(z0 + r), size_t(x0), cw), [&](int a, int b) { addWall(a, r, b - a, AlongX); });
+
+    // Vertical runs are followed down the columns: a run starts where a
+    // bit is set that was clear in the row above and ends where it clears
+    const int cols = cw + (x0 + cw == W ? 1 : 0);
+    int runStart[kChunkCells + 1] = {};
+    uint64_t prev = 0;
+    for (int z = 0; z <= ch; ++z) {
+        const uint64_t cur = z < ch ? bitsAt(grid.vWallRow(z0 + z), size_t(x0), cols) : 0;
+        for (uint64_t ended = prev & ~cur; ended; ended &= ended - 1) {
+            const int x = lowestBit(ended);
+            addWall(x, runStart[x], z - runStart[x], AlongZ);
+        }
+        for (uint64_t started = cur & ~prev; started; started &= started - 1) runStart[lowestBit(started)] = z;
+        prev = cur;
+    }
+    chunk.wallCount = count;
+}
+}
+
+namespace MazeMesh {
+
+const MazeVertex* unitWall() {
+    constexpr uint16_t l = kPositionScale, t = kWallHeight;
+    static const MazeVertex wall[kUnitWallVertices] = {
+        {{0, 0, 0}, PosZ, Wall}, {{l, 0, 0}, PosZ, Wall}, {{l, t, 0}, PosZ, Wall},
+        {{0, 0, 0}, PosZ, Wall}, {{l, t, 0}, PosZ, Wall}, {{0, t, 0}, PosZ, Wall},
+        {{l, 0, 0}, NegZ, Wall}, {{0, 0, 0}, NegZ, Wall}, {{0, t, 0}, NegZ, Wall},
+        {{l, 0, 0}, NegZ, Wall}, {{0, t, 0}, NegZ, Wall}, {{l, t, 0}, NegZ, Wall},
+    };
+    return wall;
+}
+
+void buildMaze(const MazeGridView& grid, Mesh& out) {
+    out.clear();
+    const int W = grid.width(), H = grid.height();
+    const int S = kPositionScale;
+    const size_t chunks = size_t(chunksAlong(W)) * size_t(chunksAlong(H));
+    out.walls.resize(chunks * kMaxChunkWalls);
+
+    for (int z0 = 0; z0 < H; z0 += kChunkCells) {
+        for (int x0 = 0; x0 < W; x0 += kChunkCells) {
+            const int cw = std::min(kChunkCells, W - x0), ch = std::min(kChunkCells, H - z0);
+            beginChunk(out, x0, z0);
+            Chunk& chunk = out.chunks.back();
+            chunk.cellsX = cw;
+            chunk.cellsZ = ch;
+            chunk.firstWall = uint32_t((out.chunks.size() - 1) * kMaxChunkWalls);
+
+            // Floor
+            addQuad(out, {0, 0, 0}, {0, 0, ch * S}, {cw * S, 0, ch * S}, {cw * S, 0, 0}, PosY, Floor);
+            buildWalls(grid, out, chunk);
+        }
+    }
+}
+
+int chunkAt(const MazeGridView& grid, int x, int y) {
+    return (y / kChunkCells) * chunksAlong(grid.width()) + x / kChunkCells;
+}
+
+void rebuildWalls(const MazeGridView& grid, Mesh& mesh, int chunk) {
+    buildWalls(grid, mesh, mesh.chunks[size_t(chunk)]);
+}
+
+void appendPath(const std::vector<Coord>& path, Mesh& out) {
+    const int S = kPositionScale, y = 2, lo = 15, hi = 85;
+    std::vector<Coord> cells;
+    for (const Coord& c : path)
+        if (c.x >= 0 && c.y >= 0) cells.push_back(c);
+    auto chunkOf = [](const Coord& c) { return std::make_pair(c.y / kChunkCells, c.x / kChunkCells); };
+    std::sort(cells.begin(), cells.end(), [&](const Coord& a, const Coord& b) { return chunkOf(a) < chunkOf(b); });
+    for (size_t i = 0; i < cells.size(); ++i) {
+        if (i == 0 || chunkOf(cells[i]) != chunkOf(cells[i - 1]))
+            beginChunk(out, cells[i].x / kChunkCells * kChunkCells, cells[i].y / kChunkCells * kChunkCells);
+        const int x = (cells[i].x - out.chunks.back().originX) * S, z = (cells[i].y - out.chunks.back().originZ) * S;
+        addQuad(out, {x + lo, y, z + lo}, {x + lo, y, z + hi}, {x + hi, y, z + hi}, {x + hi, y, z + lo}, PosY, PathMarker);
+    }
+}
+
+Frustum::Frustum(const float* m) {
+    // Gribb-Hartmann: each plane is the last row of the matrix plus or minus
+    // one of the others
+    for (int i = 0; i < 3; ++i)
+        for (int k = 0; k < 4; ++k) {
+            planes[2 * i][k] = m[4 * k + 3] + m[4 * k + i];
+            planes[2 * i + 1][k] = m[4 * k + 3] - m[4 * k + i];
+        }
+}
+
+bool Frustum::intersects(const float lo[3], const float hi[3]) const {
+    // The box corner furthest along each plane's normal decides
+    for (const float* p : planes) {
+        float d = p[3];
+        for (int k = 0; k < 3; ++k) d += p[k] * (p[k] >= 0 ? hi[k] : lo[k]);
+        if (d < 0) return false;
+    }
+    return true;
+}
+
+bool Frustum::intersects(const Chunk& chunk) const {
+    const float lo[3] = {float(chunk.originX), 0.0f, float(chunk.originZ)};
+    const float hi[3] = {float(chunk.originX + chunk.cellsX), float(kWallHeight) / kPositionScale,
+                         float(chunk.originZ + chunk.cellsZ)};
+    return intersects(lo, hi);
+}
+
+} // namespace MazeMesh
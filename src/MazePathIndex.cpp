@@ -0,0 +1,129 @@
+#include "MazePathIndex.h"
+#include "MazeBits.h"
+#include <algorithm>
+
+bool MazePathIndex::build(const MazeGridView& grid) {
+    *this = MazePathIndex();
+    const int W = grid.width(), H = grid.height();
+    const size_t n = size_t(W) * size_t(H);
+    if (n > size_t(INT32_MAX) / 2) return false;
+
+    std::vector<int32_t> parent(n, -1);
+    std::vector<uint32_t> depth(n, 0), first(n, UINT32_MAX);
+    std::vector<int32_t> tour;
+    tour.reserve(2 * n - 1);
+
+    // Iterative DFS from cell 0. The stack holds each open cell together with
+    // the next direction to try (0..3 = N, E, S, W).
+    std::vector<std::pair<int32_t, uint8_t>> stack;
+    stack.reserve(n);
+    stack.push_back({0, 0});
+    first[0] = 0;
+    tour.push_back(0);
+    size_t reached = 1;
+    while (!stack.empty()) {
+        auto& top = stack.back();
+        const int32_t c = top.first;
+        const int x = c % W, y = c / W;
+        int32_t next = -1;
+        while (top.second < 4 && next < 0) {
+            switch (top.second++) {
+                case 0: if (y > 0 && !grid.wallN(x,y)) next = c - W; break;
+                case 1: if (x + 1 < W && !grid.wallE(x,y)) next = c + 1; break;
+                case 2: if (y + 1 < H && !grid.wallS(x,y)) next = c + W; break;
+                case 3: if (x > 0 && !grid.wallW(x,y)) next = c - 1; break;
+            }
+            if (next == parent[size_t(c)]) next = -1;
+        }
+        if (next < 0) {
+            stack.pop_back();
+            if (!stack.empty()) tour.push_back(stack.back().first);
+            continue;
+        }
+        if (first[size_t(next)] != UINT32_MAX) return false; // second route to a cell: a loop
+        parent[size_t(next)] = c;
+        depth[size_t(next)] = depth[size_t(c)] + 1;
+        first[size_t(next)] = uint32_t(tour.size());
+        tour.push_back(next);
+        stack.push_back({next, 0});
+        ++reached;
+    }
+    if (reached != n) return false;
+
+    width_ = W;
+    height_ = H;
+    parent_ = std::move(parent);
+    depth_ = std::move(depth);
+    first_ = std::move(first);
+    tour_ = std::move(tour);
+
+    // Inside a block, inBlock_[i] has a bit for every position j <= i whose
+    // depth is below all depths in (j, i]: the lowest such bit at or after l is
+    // the minimum of [l, i].
+    const uint32_t m = uint32_t(tour_.size());
+    inBlock_.resize(m);
+    for (uint32_t start = 0; start < m; start += kBlock) {
+        uint32_t stackMask = 0;
+        const uint32_t end = std::min(m, start + kBlock);
+        for (uint32_t i = start; i < end; ++i) {
+            const uint32_t d = depth_[size_t(tour_[i])];
+            while (stackMask && depth_[size_t(tour_[start + uint32_t(highestBit(stackMask))])] > d)
+                stackMask &= ~(uint32_t(1) << highestBit(stackMask));
+            stackMask |= uint32_t(1) << (i - start);
+            inBlock_[i] = stackMask;
+        }
+    }
+
+    const uint32_t blocks = (m + kBlock - 1) / kBlock;
+    blockTable_.emplace_back(blocks);
+    for (uint32_t b = 0; b < blocks; ++b)
+        blockTable_[0][b] = minInBlock(b * kBlock, std::min(m, (b + 1) * kBlock) - 1);
+    for (uint32_t k = 1; (uint32_t(1) << k) <= blocks; ++k) {
+        const std::vector<uint32_t>& prev = blockTable_[k - 1];
+        std::vector<uint32_t> level(blocks - (uint32_t(1) << k) + 1);
+        for (uint32_t b = 0; b < level.size(); ++b)
+            level[b] = shallower(prev[b], prev[b + (uint32_t(1) << (k - 1))]);
+        blockTable_.push_back(std::move(level));
+    }
+    return true;
+}
+
+uint32_t MazePathIndex::minInBlock(uint32_t l, uint32_t r) const {
+    const uint32_t start = l - l % kBlock;
+    return start + uint32_t(lowestBit(inBlock_[r] & (~uint32_t(0) << (l - start))));
+}
+
+uint32_t MazePathIndex::minPos(uint32_t l, uint32_t r) const {
+    const uint32_t bl = l / kBlock, br = r / kBlock;
+    if (bl == br) return minInBlock(l, r);
+    uint32_t best = shallower(minInBlock(l, bl * kBlock + kBlock - 1), minInBlock(br * kBlock, r));
+    if (bl + 1 < br) {
+        const int k = highestBit(br - bl - 1);
+        best = shallower(best, blockTable_[size_t(k)][bl + 1]);
+        best = shallower(best, blockTable_[size_t(k)][br - (uint32_t(1) << k)]);
+    }
+    return best;
+}
+
+int32_t MazePathIndex::lca(int32_t a, int32_t b) const {
+    uint32_t l = first_[size_t(a)], r = first_[size_t(b)];
+    if (l > r) std::swap(l, r);
+    return tour_[minPos(l, r)];
+}
+
+uint32_t MazePathIndex::distance(Coord a, Coord b) const {
+    const int32_t ia = index(a), ib = index(b);
+    return depth_[size_t(ia)] + depth_[size_t(ib)] - 2 * depth_[size_t(lca(ia, ib))];
+}
+
+void MazePathIndex::path(Coord a, Coord b, std::vector<Coord>& out) const {
+    int32_t ia = index(a), ib = index(b);
+    const int32_t top = lca(ia, ib);
+    const uint32_t up = depth_[size_t(ia)] - depth_[size_t(top)];
+    const uint32_t down = depth_[size_t(ib)] - depth_[size_t(top)];
+    out.resize(size_t(up) + size_t(down) + 1);
+    // a climbs to the ancestor filling the front; b climbs filling the back
+    for (uint32_t i = 0; i < up; ++i, ia = parent_[size_t(ia)]) out[i] = coord(ia);
+    out[up] = coord(top);
+    for (uint32_t i = 0; i < down; ++i, ib = parent_[size_t(ib)]) out[size_t(up) + down - i] = coord(ib);
+}
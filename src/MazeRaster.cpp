@@ -0,0 +1,349 @@
+#include "MazeRaster.h"
+#include "MazeParallel.h"
+#include <QFile>
+#include <QByteArray>
+#include <QtEndian>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <thread>
+
+namespace MazeRaster {
+
+namespace {
+
+struct Metrics {
+    int cell, wall;
+};
+
+Metrics metrics(const Style& style) {
+    const int wall = std::max(1, style.wallPixels);
+    return Metrics{std::max(style.cellPixels, wall + 1), wall};
+}
+
+// Raw deflate data of fixed-Huffman blocks whose only matches are runs
+// (distance 1). Rendered rows are long runs, and rows repeated from the one
+// above are all zero after PNG's Up filter, so this gets most of what a full
+// deflate would without a window or a zlib dependency. Each deflater ends on
+// a byte boundary, so pieces compressed on different threads concatenate
+// into one stream.
+class RunDeflater {
+public:
+    explicit RunDeflater(QByteArray& out) : out_(out) {
+        putBits(0, 1); // BFINAL clear: the stream's last block comes from finishStream()
+        putBits(1, 2); // BTYPE 01, fixed codes
+    }
+
+    void add(const uint8_t* data, size_t n) {
+        for (size_t i = 0; i < n;) {
+            const uint8_t b = data[i];
+            size_t end = i + 1;
+            while (end < n && data[end] == b) ++end;
+            adler(b, end - i);
+            literal(b);
+            size_t run = end - i - 1; // repeats after the literal
+            while (run >= 3) {
+                size_t len = std::min<size_t>(run, 258);
+                if (run - len > 0 && run - len < 3) len -= 3; // leave a remainder long enough to match
+                match(len);
+                run -= len;
+            }
+            for (; run > 0; --run) literal(b);
+            i = end;
+        }
+        length_ += n;
+    }
+
+    // Ends the block, then pads to a byte with an empty stored block
+    void finish() {
+        code(256);
+        putBits(0, 3); // BFINAL clear, BTYPE 00
+        for (; bitCount_ > 0; bitCount_ -= 8, bits_ >>= 8) out_.append(char(bits_ & 0xFF));
+        bits_ = 0;
+        bitCount_ = 0;
+        out_.append("\x00\x00\xff\xff", 4); // LEN 0, NLEN
+    }
+
+    // Adler-32 of the input so far, seeded with 1 as zlib does
+    uint32_t checksum() const { return (b_ << 16) | a_; }
+    uint64_t length() const { return length_; }
+
+    // zlib header, and the final empty block plus Adler-32 trailer
+    static void startStream(QByteArray& out) { out.append("\x78\x01", 2); }
+    static void finishStream(QByteArray& out, uint32_t checksum) {
+        char trailer[6] = {0x03, 0x00}; // BFINAL, fixed codes, end of block
+        qToBigEndian<quint32>(checksum, trailer + 2);
+        out.append(trailer, 6);
+    }
+    // Adler-32 of two pieces concatenated, given the second's length (zlib's adler32_combine)
+    static uint32_t combine(uint32_t first, uint32_t second, uint64_t secondLength) {
+        const uint32_t base = 65521;
+        const uint32_t rem = uint32_t(secondLength % base);
+        uint32_t sum1 = first & 0xFFFF;
+        uint32_t sum2 = uint32_t((uint64_t(rem) * sum1) % base);
+        sum1 += (second & 0xFFFF) + base - 1;
+        sum2 += (first >> 16) + (second >> 16) + base - rem;
+        if (sum1 >= base) sum1 -= base;
+        if (sum1 >= base) sum1 -= base;
+        if (sum2 >= 2 * base) sum2 -= 2 * base;
+        if (sum2 >= base) sum2 -= base;
+        return (sum2 << 16) | sum1;
+    }
+
+private:
+    void putBits(uint32_t v, int n) {
+        bits_ |= uint64_t(v) << bitCount_;
+        bitCount_ += n;
+        if (bitCount_ >= 32) {
+            char le[4];
+            qToLittleEndian<quint32>(quint32(bits_), le);
+            out_.append(le, 4);
+            bits_ >>= 32;
+            bitCount_ -= 32;
+        }
+    }
+    // Huffman codes go out most significant bit first, so the fixed code
+    // table is kept bit-reversed, ready for putBits
+    struct Code { uint16_t bits; uint8_t length; };
+    static const Code* fixedCodes() {
+        static const auto table = []() {
+            std::vector<Code> t(288);
+            for (unsigned sym = 0; sym < 288; ++sym) {
+                uint32_t c; int n;
+                if (sym < 144) { c = 0x30 + sym; n = 8; }
+                else if (sym < 256) { c = 0x190 + sym - 144; n = 9; }
+                else if (sym < 280) { c = sym - 256; n = 7; }
+                else { c = 0xC0 + sym - 280; n = 8; }
+                uint32_t r = 0;
+                for (int i = 0; i < n; ++i) r |= ((c >> i) & 1u) << (n - 1 - i);
+                t[sym] = Code{uint16_t(r), uint8_t(n)};
+            }
+            return t;
+        }();
+        return table.data();
+    }
+    void code(unsigned sym) {
+        const Code c = codes_[sym];
+        putBits(c.bits, c.length);
+    }
+    void literal(uint8_t b) { code(b); }
+    void match(size_t len) {
+        static const uint16_t base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                          35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static const uint8_t extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                          3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        int k = 28;
+        while (base[k] > len) --k;
+        code(257 + unsigned(k));
+        if (extra[k]) putBits(uint32_t(len - base[k]), extra[k]);
+        putBits(0, 5); // distance code 0: distance 1
+    }
+    // Adler-32 of `n` copies of `b`, in closed form per bounded piece
+    void adler(uint8_t b, size_t n) {
+        while (n > 0) {
+            const uint64_t k = std::min<size_t>(n, 1u << 16);
+            b_ = uint32_t((b_ + k * a_ + uint64_t(b) * (k * (k + 1) / 2)) % 65521);
+            a_ = uint32_t((a_ + k * b) % 65521);
+            n -= size_t(k);
+        }
+    }
+
+    QByteArray& out_;
+    const Code* codes_ = fixedCodes();
+    uint64_t bits_ = 0;
+    int bitCount_ = 0;
+    uint32_t a_ = 1, b_ = 0;
+    uint64_t length_ = 0;
+};
+
+uint32_t crc32(const char* data, size_t n, uint32_t crc = 0) {
+    static const auto table = []() {
+        std::vector<uint32_t> t(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) crc = table[(crc ^ uint8_t(data[i])) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+bool writeChunk(QFile& f, const char* type, const QByteArray& data) {
+    char len[4], crc[4];
+    qToBigEndian<quint32>(quint32(data.size()), len);
+    uint32_t c = crc32(type, 4);
+    c = crc32(data.constData(), size_t(data.size()), c);
+    qToBigEndian<quint32>(c, crc);
+    return f.write(len, 4) == 4 && f.write(type, 4) == 4 && f.write(data) == data.size() && f.write(crc, 4) == 4;
+}
+
+}
+
+int64_t imageWidth(const MazeGridView& grid, const Style& style) {
+    const Metrics m = metrics(style);
+    return int64_t(grid.width()) * m.cell + m.wall;
+}
+
+int64_t imageHeight(const MazeGridView& grid, const Style& style) {
+    const Metrics m = metrics(style);
+    return int64_t(grid.height()) * m.cell + m.wall;
+}
+
+PathCells::PathCells(const std::vector<Coord>& path, int width) : width_(width) {
+    keys_.reserve(path.size());
+    for (const Coord& c : path)
+        if (c.x >= 0 && c.x < width && c.y >= 0) keys_.push_back(uint64_t(c.y) * uint64_t(width) + uint64_t(c.x));
+    std::sort(keys_.begin(), keys_.end());
+}
+
+void PathCells::markRow(int y, uint8_t* row) const {
+    std::memset(row, 0, size_t(width_));
+    const uint64_t first = uint64_t(y) * uint64_t(width_);
+    for (auto it = std::lower_bound(keys_.begin(), keys_.end(), first); it != keys_.end() && *it < first + uint64_t(width_); ++it)
+        row[*it - first] = 1;
+}
+
+void renderRows(const MazeGridView& grid, const PathCells& path, const Style& style,
+                int y0, int y1, uint8_t* out, size_t stride) {
+    const Metrics m = metrics(style);
+    const int W = grid.width(), H = grid.height();
+    const size_t interior = size_t(m.cell - m.wall);
+    // Path marks of the current cell row and the one above
+    std::vector<uint8_t> cur(static_cast<size_t>(W)), above(static_cast<size_t>(W));
+    int marked = -2;
+    auto bit = [](const uint64_t* row, int i) { return (row[i >> 6] >> (i & 63)) & 1u; };
+    for (int py = y0; py < y1; ++py, out += stride) {
+        const int cy = py / m.cell, oy = py % m.cell;
+        if (!path.empty() && cy != marked) {
+            if (cy == marked + 1) std::swap(cur, above);
+            else if (cy > 0) path.markRow(cy - 1, above.data());
+            if (cy < H) path.markRow(cy, cur.data());
+            marked = cy;
+        }
+        const bool pathAbove = !path.empty() && cy > 0 && cy < H;
+        uint8_t* p = out;
+        if (oy < m.wall) {
+            // Posts and the walls on the north edge of cell row cy (south edge of the maze when cy == H)
+            const uint64_t* h = grid.hWallRow(cy);
+            for (int cx = 0; cx < W; ++cx) {
+                std::memset(p, Wall, size_t(m.wall));
+                p += m.wall;
+                const uint8_t fill = bit(h, cx) ? Wall
+                                   : pathAbove && cur[size_t(cx)] && above[size_t(cx)] ? Path : Background;
+                std::memset(p, fill, interior);
+                p += interior;
+            }
+            std::memset(p, Wall, size_t(m.wall));
+        } else {
+            const uint64_t* v = grid.vWallRow(cy);
+            const bool anyPath = !path.empty();
+            for (int cx = 0; cx < W; ++cx) {
+                const bool here = anyPath && cur[size_t(cx)];
+                const uint8_t edge = bit(v, cx) ? Wall : here && cx > 0 && cur[size_t(cx) - 1] ? Path : Background;
+                std::memset(p, edge, size_t(m.wall));
+                p += m.wall;
+                std::memset(p, here ? Path : Background, interior);
+                p += interior;
+            }
+            std::memset(p, bit(v, W) ? Wall : Background, size_t(m.wall));
+        }
+    }
+}
+
+void render(const MazeGridView& grid, const PathCells& path, const Style& style,
+            uint8_t* out, size_t stride, int threads) {
+    const int height = int(imageHeight(grid, style));
+    const int band = 64;
+    parallelFor(size_t((height + band - 1) / band), threads, [&](size_t i) {
+        const int y0 = int(i) * band;
+        renderRows(grid, path, style, y0, std::min(height, y0 + band), out + size_t(y0) * stride, stride);
+    });
+}
+
+bool savePNG(const MazeGridView& grid, const PathCells& path, const Style& style,
+             const QString& filePath, int threads) {
+    const int64_t width64 = imageWidth(grid, style), height64 = imageHeight(grid, style);
+    if (grid.width() <= 0 || grid.height() <= 0 || width64 > INT_MAX || height64 > INT_MAX) return false;
+    const int width = int(width64), height = int(height64);
+    const size_t rowBytes = size_t(width);
+    // Strips of about 16 MiB keep every worker busy without holding the image
+    const size_t workers = threads > 0 ? size_t(threads) : std::max(1u, std::thread::hardware_concurrency());
+    const int stripRows = int(std::min<size_t>(std::max<size_t>((size_t(16) << 20) / rowBytes, workers), 4096));
+
+    QFile f(filePath);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    bool ok = f.write("\x89PNG\r\n\x1a\n", 8) == 8;
+    QByteArray ihdr(13, '\0');
+    qToBigEndian<quint32>(quint32(width), ihdr.data());
+    qToBigEndian<quint32>(quint32(height), ihdr.data() + 4);
+    ihdr[8] = 8; // bit depth
+    ihdr[9] = 3; // palette colour
+    ok = ok && writeChunk(f, "IHDR", ihdr);
+    QByteArray plte;
+    for (uint32_t c : {style.background, style.wall, style.path}) {
+        plte.append(char((c >> 16) & 0xFF));
+        plte.append(char((c >> 8) & 0xFF));
+        plte.append(char(c & 0xFF));
+    }
+    ok = ok && writeChunk(f, "PLTE", plte);
+
+    // Each band of a strip is rendered, then filtered and deflated, by one
+    // worker; the pieces are written in order and their checksums combined
+    QByteArray idat;
+    RunDeflater::startStream(idat);
+    uint32_t checksum = 1;
+    std::vector<uint8_t> strip(size_t(stripRows + 1) * rowBytes); // row 0: last row of the previous strip
+    const size_t maxBands = std::min(workers, size_t(stripRows));
+    std::vector<QByteArray> pieces(maxBands);
+    std::vector<uint32_t> pieceSums(maxBands);
+    std::vector<uint64_t> pieceLengths(maxBands);
+    for (int y0 = 0; y0 < height && ok; y0 += stripRows) {
+        const int rows = std::min(stripRows, height - y0);
+        const int band = int((size_t(rows) + workers - 1) / workers);
+        const size_t bands = size_t((rows + band - 1) / band);
+        parallelFor(bands, threads, [&](size_t i) {
+            const int r0 = int(i) * band;
+            renderRows(grid, path, style, y0 + r0, y0 + std::min(rows, r0 + band),
+                       strip.data() + size_t(r0 + 1) * rowBytes, rowBytes);
+        });
+        // Filtering looks one row up, so it waits until the whole strip is drawn
+        parallelFor(bands, threads, [&](size_t i) {
+            const int r0 = int(i) * band, r1 = std::min(rows, r0 + band);
+            QByteArray& piece = pieces[i];
+            piece.clear();
+            RunDeflater deflater(piece);
+            const std::vector<uint8_t> zeros(rowBytes);
+            for (int r = r0; r < r1; ++r) {
+                const uint8_t* row = strip.data() + size_t(r + 1) * rowBytes;
+                // A row repeating the one above becomes all zeros under the Up filter
+                const bool repeat = y0 + r > 0 && std::memcmp(row, row - rowBytes, rowBytes) == 0;
+                const uint8_t filter = repeat ? 2 : 0;
+                deflater.add(&filter, 1);
+                deflater.add(repeat ? zeros.data() : row, rowBytes);
+            }
+            deflater.finish();
+            pieceSums[i] = deflater.checksum();
+            pieceLengths[i] = deflater.length();
+        });
+        // The rendered rows of the next strip follow this one's last row
+        std::memcpy(strip.data(), strip.data() + size_t(rows) * rowBytes, rowBytes);
+        for (size_t i = 0; i < bands && ok; ++i) {
+            idat.append(pieces[i]);
+            checksum = RunDeflater::combine(checksum, pieceSums[i], pieceLengths[i]);
+            if (idat.size() >= (1 << 20)) {
+                ok = writeChunk(f, "IDAT", idat);
+                idat.clear();
+            }
+        }
+    }
+    RunDeflater::finishStream(idat, checksum);
+    ok = ok && writeChunk(f, "IDAT", idat) && writeChunk(f, "IEND", QByteArray());
+    f.close();
+    if (!ok) f.remove();
+    return ok;
+}
+
+}
@@ -0,0 +1,59 @@
+#include "MazeSolveCache.h"
+#include "MazeRandom.h"
+
+namespace {
+// Approximate footprint of one entry: list node, hash node and path storage
+size_t entryBytes(const std::optional<MazePath>& result) {
+    return 96 + (result ? result->nodes.size() * sizeof(Coord) : 0);
+}
+}
+
+size_t MazeSolveCache::KeyHash::operator()(const Key& k) const {
+    uint64_t h = k.wallHash;
+    h = splitmix64(h ^ ((uint64_t(uint32_t(k.start.x)) << 32) | uint32_t(k.start.y)));
+    h = splitmix64(h ^ ((uint64_t(uint32_t(k.goal.x)) << 32) | uint32_t(k.goal.y)));
+    return size_t(h ^ uint64_t(k.solver));
+}
+
+bool MazeSolveCache::lookup(const Key& key, std::optional<MazePath>& out) {
+    auto it = index_.find(key);
+    if (it == index_.end()) { ++misses_; return false; }
+    ++hits_;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    out = it->second->result;
+    return true;
+}
+
+void MazeSolveCache::store(const Key& key, const std::optional<MazePath>& result) {
+    const size_t size = entryBytes(result);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        bytes_ -= it->second->bytes;
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+    if (size > budget_) return;
+    evictTo(budget_ - size);
+    lru_.push_front(Entry{key, result, size});
+    index_.emplace(key, lru_.begin());
+    bytes_ += size;
+}
+
+void MazeSolveCache::clear() {
+    lru_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+void MazeSolveCache::setBudget(size_t bytes) {
+    budget_ = bytes;
+    evictTo(budget_);
+}
+
+void MazeSolveCache::evictTo(size_t bytes) {
+    while (bytes_ > bytes && !lru_.empty()) {
+        bytes_ -= lru_.back().bytes;
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+    }
+}
@@ -1,42 +1,418 @@
 #include "MazeSolver.h"
-#include <queue>
+#include "MazeBits.h"
 #include <algorithm>
+#include <climits>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 
-static inline int idx(const MazeGrid& g, int x, int y){ return y * g.width() + x; }
+namespace {
 
-std::optional<MazePath> MazeSolver::solveBFS(const MazeGrid& grid, Coord start, Coord goal){
-    int W = grid.width(), H = grid.height();
-    std::vector<char> vis(W*H, 0);
-    std::vector<int> parent(W*H, -1);
-    std::queue<Coord> q;
-    q.push(start);
-    vis[idx(grid,start.x,start.y)] = 1;
+// Calls f(n) for each cell index n reachable from cell i through an open wall.
+// Openings in the outer boundary (possible in loaded files) lead nowhere.
+template <class F>
+inline void forEachOpen(const MazeGridView& grid, int32_t i, F&& f) {
+    const int W = grid.width();
+    const int x = i % W, y = i / W;
+    if (y > 0 && !grid.wallN(x,y)) f(i - W);
+    if (x + 1 < W && !grid.wallE(x,y)) f(i + 1);
+    if (y + 1 < grid.height() && !grid.wallS(x,y)) f(i + W);
+    if (x > 0 && !grid.wallW(x,y)) f(i - 1);
+}
 
-    auto tryPush = [&](int x,int y,int fromIndex){
-        if (x < 0 || y < 0 || x >= W || y >= H) return;
-        int i = idx(grid,x,y);
-        if (!vis[i]){ vis[i]=1; parent[i]=fromIndex; q.push({x,y}); }
-    };
+// Sizes the scratch for n cells and opens two fresh epochs (forward = epoch,
+// backward = epoch+1); stamps left by earlier searches are all smaller.
+void beginSearch(MazeSolver::Scratch& s, size_t n) {
+    if (s.stamp.size() != n) {
+        s.stamp.assign(n, 0);
+        s.parent.resize(n);
+        s.dist.resize(n);
+        s.queue.resize(n);
+        s.epoch = 0;
+    }
+    if (s.epoch >= UINT32_MAX - 2) {
+        std::fill(s.stamp.begin(), s.stamp.end(), 0);
+        s.epoch = 0;
+    }
+    s.epoch += 2;
+}
 
-    while(!q.empty()){
-        Coord c = q.front(); q.pop();
-        if (c.x == goal.x && c.y == goal.y){
-            MazePath path; path.nodes.clear();
-            int i = idx(grid,c.x,c.y);
-            while(i != -1){
-                int y = i / W; int x = i % W;
-                path.nodes.push_back({x,y});
-                i = parent[i];
-            }
-            std::reverse(path.nodes.begin(), path.nodes.end());
+// Appends the parent chain ending at cell i, root first.
+void appendChain(const MazeSolver::Scratch& s, int W, int32_t i, std::vector<Coord>& out) {
+    const size_t first = out.size();
+    for (; i != -1; i = s.parent[size_t(i)]) out.push_back({i % W, i / W});
+    std::reverse(out.begin() + std::ptrdiff_t(first), out.end());
+}
+
+bool validEndpoints(const MazeGridView& grid, Coord start, Coord goal) {
+    return grid.inBounds(start.x, start.y) && grid.inBounds(goal.x, goal.y);
+}
+
+}
+
+std::optional<MazePath> MazeSolver::solveBFS(const MazeGridView& grid, Coord start, Coord goal){
+    Scratch scratch;
+    return solveBFS(grid, start, goal, scratch);
+}
+
+std::optional<MazePath> MazeSolver::solveAStar(const MazeGridView& grid, Coord start, Coord goal){
+    Scratch scratch;
+    return solveAStar(grid, start, goal, scratch);
+}
+
+std::optional<MazePath> MazeSolver::solveBidirectionalBFS(const MazeGridView& grid, Coord start, Coord goal){
+    Scratch scratch;
+    return solveBidirectionalBFS(grid, start, goal, scratch);
+}
+
+std::optional<MazePath> MazeSolver::solve(SolverAlgorithm alg, const MazeGridView& grid, Coord start, Coord goal,
+                                          Scratch& scratch, SolveStats* stats){
+    switch (alg) {
+        case SolverAlgorithm::AStar: return solveAStar(grid, start, goal, scratch, stats);
+        case SolverAlgorithm::BidirectionalBFS: return solveBidirectionalBFS(grid, start, goal, scratch, stats);
+        case SolverAlgorithm::BFS: break;
+    }
+    return solveBFS(grid, start, goal, scratch, stats);
+}
+
+std::optional<MazePath> MazeSolver::solveBFS(const MazeGridView& grid, Coord start, Coord goal,
+                                             Scratch& s, SolveStats* stats){
+    if (stats) *stats = SolveStats{};
+    if (!validEndpoints(grid, start, goal)) return std::nullopt;
+    const int W = grid.width();
+    beginSearch(s, size_t(W) * size_t(grid.height()));
+    const uint32_t e = s.epoch;
+    const int32_t src = start.y * W + start.x, dst = goal.y * W + goal.x;
+
+    int32_t* q = s.queue.data();
+    size_t head = 0, tail = 0;
+    s.stamp[size_t(src)] = e;
+    s.parent[size_t(src)] = -1;
+    q[tail++] = src;
+    uint64_t explored = 0;
+    while (head < tail) {
+        const int32_t i = q[head++];
+        ++explored;
+        if (i == dst) {
+            if (stats) stats->explored = explored;
+            MazePath path;
+            appendChain(s, W, i, path.nodes);
             return path;
         }
-        const Cell& cell = grid.at(c.x,c.y);
-        int ci = idx(grid,c.x,c.y);
-        if (!cell.wallN) tryPush(c.x, c.y-1, ci);
-        if (!cell.wallE) tryPush(c.x+1, c.y, ci);
-        if (!cell.wallS) tryPush(c.x, c.y+1, ci);
-        if (!cell.wallW) tryPush(c.x-1, c.y, ci);
+        forEachOpen(grid, i, [&](int32_t n) {
+            if (s.stamp[size_t(n)] == e) return;
+            s.stamp[size_t(n)] = e;
+            s.parent[size_t(n)] = i;
+            q[tail++] = n;
+        });
     }
+    if (stats) stats->explored = explored;
     return std::nullopt;
 }
+
+std::optional<MazePath> MazeSolver::solveAStar(const MazeGridView& grid, Coord start, Coord goal,
+                                               Scratch& s, SolveStats* stats){
+    if (stats) *stats = SolveStats{};
+    if (!validEndpoints(grid, start, goal)) return std::nullopt;
+    const int W = grid.width();
+    beginSearch(s, size_t(W) * size_t(grid.height()));
+    const uint32_t e = s.epoch;
+    const int32_t src = start.y * W + start.x, dst = goal.y * W + goal.x;
+    auto h = [&](int32_t i) { return std::abs(i % W - goal.x) + std::abs(i / W - goal.y); };
+
+    s.open.clear();
+    s.next.clear();
+    s.stamp[size_t(src)] = e;
+    s.dist[size_t(src)] = 0;
+    s.parent[size_t(src)] = -1;
+    s.open.push_back(src);
+    int f = h(src);
+    uint64_t explored = 0;
+    for (;;) {
+        if (s.open.empty()) {
+            if (s.next.empty()) break;
+            std::swap(s.open, s.next);
+            f += 2;
+        }
+        const int32_t i = s.open.back();
+        s.open.pop_back();
+        // A cell whose g improved after it was queued in the f+2 bucket leaves
+        // a stale entry there; it has already been expanded at the lower f.
+        if (s.dist[size_t(i)] + h(i) != f) continue;
+        ++explored;
+        if (i == dst) {
+            if (stats) stats->explored = explored;
+            MazePath path;
+            appendChain(s, W, i, path.nodes);
+            return path;
+        }
+        const int32_t g = s.dist[size_t(i)] + 1;
+        forEachOpen(grid, i, [&](int32_t n) {
+            if (s.stamp[size_t(n)] == e && s.dist[size_t(n)] <= g) return;
+            s.stamp[size_t(n)] = e;
+            s.dist[size_t(n)] = g;
+            s.parent[size_t(n)] = i;
+            (g + h(n) == f ? s.open : s.next).push_back(n);
+        });
+    }
+    if (stats) stats->explored = explored;
+    return std::nullopt;
+}
+
+std::optional<MazePath> MazeSolver::solveBidirectionalBFS(const MazeGridView& grid, Coord start, Coord goal,
+                                                          Scratch& s, SolveStats* stats){
+    if (stats) *stats = SolveStats{};
+    if (!validEndpoints(grid, start, goal)) return std::nullopt;
+    const int W = grid.width();
+    const size_t n = size_t(W) * size_t(grid.height());
+    beginSearch(s, n);
+    const uint32_t fwd = s.epoch, bwd = s.epoch + 1;
+    const int32_t src = start.y * W + start.x, dst = goal.y * W + goal.x;
+    if (src == dst) {
+        if (stats) stats->explored = 1;
+        return MazePath{{start}};
+    }
+
+    // Every cell is claimed by at most one side, so both queues fit in one
+    // array: the forward queue grows up from 0, the backward one down from n-1.
+    int32_t* q = s.queue.data();
+    size_t fHead = 0, fTail = 0, bHead = 0, bTail = 0;
+    auto seed = [&](int32_t i, uint32_t side) {
+        s.stamp[size_t(i)] = side;
+        s.dist[size_t(i)] = 0;
+        s.parent[size_t(i)] = -1;
+    };
+    seed(src, fwd); q[fTail++] = src;
+    seed(dst, bwd); q[n - 1 - bTail++] = dst;
+
+    int best = INT_MAX;
+    int32_t meetF = -1, meetB = -1;
+    uint64_t explored = 0;
+    while (fHead < fTail && bHead < bTail && best == INT_MAX) {
+        const bool forward = fTail - fHead <= bTail - bHead;
+        const uint32_t mine = forward ? fwd : bwd, other = forward ? bwd : fwd;
+        size_t& head = forward ? fHead : bHead;
+        size_t& tail = forward ? fTail : bTail;
+        // Finish the whole level so the shortest of its meeting edges is found
+        for (const size_t levelEnd = tail; head < levelEnd; ++head) {
+            const int32_t i = forward ? q[head] : q[n - 1 - head];
+            ++explored;
+            forEachOpen(grid, i, [&](int32_t c) {
+                const uint32_t st = s.stamp[size_t(c)];
+                if (st == mine) return;
+                if (st == other) {
+                    const int len = s.dist[size_t(i)] + 1 + s.dist[size_t(c)];
+                    if (len < best) {
+                        best = len;
+                        meetF = forward ? i : c;
+                        meetB = forward ? c : i;
+                    }
+                    return;
+                }
+                s.stamp[size_t(c)] = mine;
+                s.dist[size_t(c)] = s.dist[size_t(i)] + 1;
+                s.parent[size_t(c)] = i;
+                if (forward) q[tail++] = c; else q[n - 1 - tail++] = c;
+            });
+        }
+    }
+    if (stats) stats->explored = explored;
+    if (best == INT_MAX) return std::nullopt;
+
+    MazePath path;
+    path.nodes.reserve(size_t(best) + 1);
+    appendChain(s, W, meetF, path.nodes);
+    for (int32_t i = meetB; i != -1; i = s.parent[size_t(i)]) path.nodes.push_back({i % W, i / W});
+    return path;
+}
+
+namespace {
+
+// Per-word open-wall masks for the distance field. Bit i of word k stands for
+// cell 64k+i of the row; a set bit means the cell can step in that direction.
+struct OpenMasks {
+    const MazeGridView& grid;
+    size_t S;     // cell words per row
+    size_t VS;    // vertical wall words per row
+    uint64_t tail;
+
+    uint64_t rowMask(size_t k) const { return k + 1 == S ? tail : ~uint64_t(0); }
+    uint64_t east(int y, size_t k) const {
+        const uint64_t* v = grid.vWallRow(y);
+        const uint64_t walls = (v[k] >> 1) | (k + 1 < VS ? v[k + 1] << 63 : 0);
+        return ~walls & rowMask(k);
+    }
+    uint64_t west(int y, size_t k) const { return ~grid.vWallRow(y)[k] & rowMask(k); }
+    uint64_t north(int y, size_t k) const { return ~grid.hWallRow(y)[k] & rowMask(k); }
+    uint64_t south(int y, size_t k) const { return ~grid.hWallRow(y + 1)[k] & rowMask(k); }
+};
+
+// Threads kept for the whole distance field: run() hands every worker its
+// band of one level and returns once all of them are done, so dense levels
+// pay a wake-up instead of a thread start each. Band 0 runs on the caller.
+class LevelWorkers {
+public:
+    explicit LevelWorkers(int bands) {
+        for (int t = 1; t < bands; ++t) pool_.emplace_back([this, t]() { work(t); });
+    }
+    ~LevelWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        start_.notify_all();
+        for (std::thread& th : pool_) th.join();
+    }
+    void run(const std::function<void(int)>& job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &job;
+            pending_ = pool_.size();
+            ++generation_;
+        }
+        start_.notify_all();
+        job(0);
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this]() { return pending_ == 0; });
+    }
+
+private:
+    void work(int band) {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            start_.wait(lock, [&]() { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+            lock.unlock();
+            (*job_)(band);
+            lock.lock();
+            if (--pending_ == 0) done_.notify_one();
+        }
+    }
+
+    std::vector<std::thread> pool_;
+    std::mutex mutex_;
+    std::condition_variable start_, done_;
+    const std::function<void(int)>* job_ = nullptr;
+    uint64_t generation_ = 0;
+    size_t pending_ = 0;
+    bool stop_ = false;
+};
+
+}
+
+uint32_t MazeSolver::distanceField(const MazeGridView& grid, const std::vector<Coord>& sources,
+                                   uint32_t* out, int threads){
+    const int W = grid.width(), H = grid.height();
+    const size_t S = grid.hWordsPerRow();
+    const size_t total = S * size_t(H);
+    const OpenMasks open{grid, S, grid.vWordsPerRow(), MazeGrid::tailMask(size_t(W))};
+    if (threads <= 0) threads = int(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::fill(out, out + size_t(W) * size_t(H), kUnreachable);
+    // In queue mode `out` itself marks visited cells; the bitsets are only
+    // built when levels switch to dense mode.
+    std::vector<uint64_t> visited, frontier, next;
+    std::vector<int32_t> cells, nextCells;
+
+    for (const Coord& c : sources) {
+        if (!grid.inBounds(c.x, c.y)) continue;
+        const int32_t i = c.y * W + c.x;
+        if (out[size_t(i)] == 0) continue;
+        out[size_t(i)] = 0;
+        cells.push_back(i);
+    }
+    if (cells.empty()) return kUnreachable;
+
+    // Dense levels: each row pulls its next frontier from its own and the two
+    // neighbouring frontier rows, 64 cells per word, so row bands are independent.
+    auto denseRows = [&](int y0, int y1, uint32_t level, size_t& found) {
+        for (int y = y0; y < y1; ++y) {
+            const size_t base = size_t(y) * S;
+            uint32_t* row = out + size_t(y) * size_t(W);
+            for (size_t k = 0; k < S; ++k) {
+                const uint64_t f = frontier[base + k];
+                uint64_t bits = ((f & open.east(y, k)) << 1) | ((f & open.west(y, k)) >> 1);
+                if (k > 0) bits |= (frontier[base + k - 1] & open.east(y, k - 1)) >> 63;
+                if (k + 1 < S) bits |= (frontier[base + k + 1] & open.west(y, k + 1)) << 63;
+                if (y > 0) bits |= frontier[base - S + k] & open.north(y, k);
+                if (y + 1 < H) bits |= frontier[base + S + k] & open.south(y, k);
+                bits &= open.rowMask(k) & ~visited[base + k];
+                next[base + k] = bits;
+                if (!bits) continue;
+                visited[base + k] |= bits;
+                found += size_t(popCount(bits));
+                for (uint64_t b = bits; b; b &= b - 1) row[k * 64 + size_t(lowestBit(b))] = level;
+            }
+        }
+    };
+
+    // Thin frontiers, which is all a perfect maze ever has, expand from a flat
+    // cell queue; once the frontier holds more than half as many cells as the
+    // grid has words, sweeping bitset words is cheaper and the levels switch
+    // to dense mode.
+    const bool parallel = threads > 1 && total >= (size_t(1) << 16);
+    uint32_t level = 0;
+    const int band = (H + threads - 1) / threads;
+    std::vector<size_t> found(size_t(parallel ? threads : 1));
+    const std::function<void(int)> denseBand = [&](int t) {
+        const int y0 = std::min(H, t * band), y1 = std::min(H, y0 + band);
+        denseRows(y0, y1, level, found[size_t(t)]);
+    };
+    std::unique_ptr<LevelWorkers> workers; // started by the first dense level
+    size_t frontierCells = cells.size();
+    bool dense = false;
+    while (frontierCells) {
+        ++level;
+        const bool wantDense = frontierCells * 2 > total;
+        if (wantDense && !dense) {
+            visited.assign(total, 0);
+            frontier.assign(total, 0);
+            next.assign(total, 0);
+            for (int y = 0; y < H; ++y) {
+                const uint32_t* row = out + size_t(y) * size_t(W);
+                for (int x = 0; x < W; ++x)
+                    if (row[x] != kUnreachable) visited[size_t(y) * S + size_t(x >> 6)] |= uint64_t(1) << (x & 63);
+            }
+            for (int32_t c : cells) frontier[size_t(c / W) * S + size_t((c % W) >> 6)] |= uint64_t(1) << ((c % W) & 63);
+            dense = true;
+        } else if (!wantDense && dense) {
+            cells.clear();
+            for (size_t word = 0; word < total; ++word) {
+                const int32_t rowStart = int32_t(word / S) * W + int32_t((word % S) * 64);
+                for (uint64_t b = frontier[word]; b; b &= b - 1) cells.push_back(rowStart + lowestBit(b));
+            }
+            dense = false;
+        }
+
+        if (dense) {
+            std::fill(found.begin(), found.end(), 0);
+            if (parallel) {
+                if (!workers) workers = std::make_unique<LevelWorkers>(threads);
+                workers->run(denseBand);
+            } else {
+                denseRows(0, H, level, found[0]);
+            }
+            std::swap(frontier, next);
+            frontierCells = 0;
+            for (size_t f : found) frontierCells += f;
+            continue;
+        }
+
+        nextCells.clear();
+        for (int32_t c : cells) {
+            forEachOpen(grid, c, [&](int32_t n) {
+                if (out[size_t(n)] != kUnreachable) return;
+                out[size_t(n)] = level;
+                nextCells.push_back(n);
+            });
+        }
+        std::swap(cells, nextCells);
+        frontierCells = cells.size();
+    }
+    return level - 1;
+}
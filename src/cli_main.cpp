@@ -0,0 +1,320 @@
+// Headless command-line front end: generation, solving, conversion and export
+// with optional machine-readable timings. Links maze_core and Qt6::Core only.
+#include "MazeGenerator.h"
+#include "MazeSolver.h"
+#include "MazeIO.h"
+#include "MazeFingerprint.h"
+#include "MazeRaster.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <fstream>
+#include <memory>
+
+namespace {
+
+QTextStream& out(){ static QTextStream s(stdout); return s; }
+QTextStream& err(){ static QTextStream s(stderr); return s; }
+
+double msSince(const QElapsedTimer& t){ return double(t.nsecsElapsed()) / 1e6; }
+
+bool parseCoord(const QString& text, Coord& c){
+    const QStringList parts = text.split(',');
+    if (parts.size() != 2) return false;
+    bool okX=false, okY=false;
+    c.x = parts[0].toInt(&okX);
+    c.y = parts[1].toInt(&okY);
+    return okX && okY;
+}
+
+bool parseRect(const QString& text, MazeRect& r){
+    const QStringList parts = text.split(',');
+    if (parts.size() != 4) return false;
+    bool ok[4] = {};
+    r = MazeRect{parts[0].toInt(&ok[0]), parts[1].toInt(&ok[1]), parts[2].toInt(&ok[2]), parts[3].toInt(&ok[3])};
+    return ok[0] && ok[1] && ok[2] && ok[3] && r.width > 0 && r.height > 0;
+}
+
+// Writes a grid in the format implied by the file extension
+bool saveByExtension(const MazeGrid& grid, const MazeConfig& cfg, const QString& path, bool compact){
+    const QString ext = QFileInfo(path).suffix().toLower();
+    if (ext == "json") return MazeIO::saveToJson(grid, cfg, path, compact ? MazeIO::JsonEncoding::Bitmask
+                                                                          : MazeIO::JsonEncoding::Cells);
+    if (ext == "mzb") return MazeIO::saveBinary(grid, cfg, path);
+    if (ext == "mzc") return MazeIO::saveCompact(grid, cfg, path);
+    if (ext == "mzt") return MazeIO::saveTiled(grid, cfg, path);
+    if (ext == "txt") return MazeIO::saveAscii(grid, path);
+    if (ext == "svg") return MazeIO::saveSvg(grid, path);
+    if (ext == "png") return MazeRaster::savePNG(grid, {}, {}, path);
+    err() << "Unsupported output format: " << path << Qt::endl;
+    return false;
+}
+
+struct Options {
+    QCommandLineOption width{"width", "Maze width in cells.", "cells", "20"};
+    QCommandLineOption height{"height", "Maze height in cells.", "cells", "20"};
+    QCommandLineOption seed{"seed", "Seed (0 = random).", "seed", "0"};
+    QCommandLineOption algorithm{"algorithm", "RecursiveBacktracking, Prims, Eller or Kruskal.", "name", "RecursiveBacktracking"};
+    QCommandLineOption rng{"rng", "Mt19937_64, Xoshiro256StarStar or Pcg64.", "name", "Mt19937_64"};
+    QCommandLineOption threads{"threads", "Worker threads (0 = hardware concurrency).", "n", "1"};
+    QCommandLineOption count{"count", "generate: number of consecutive seeds, starting at --seed (1 if 0), to write as a batch file.", "n", "1"};
+    QCommandLineOption output{QStringList{"o", "output"}, "Output file (.json, .mzb, .mzc, .mzt, .txt, .svg or .png; batch files for --count > 1).", "file"};
+    QCommandLineOption start{"start", "solve: start cell.", "x,y"};
+    QCommandLineOption goal{"goal", "solve: goal cell (default: opposite corner).", "x,y"};
+    QCommandLineOption solver{"solver", "solve: BFS, AStar or BidirectionalBFS.", "name", "BFS"};
+    QCommandLineOption region{"region", "Read only this window of a tiled (.mzt) input.", "x,y,w,h"};
+    QCommandLineOption compact{"compact", "Write JSON cells as wall bitmasks (N=1, E=2, S=4, W=8)."};
+    QCommandLineOption canonical{"canonical", "dedup: treat rotations and mirror images as duplicates."};
+    QCommandLineOption json{"json", "Print results and timings as JSON."};
+};
+
+bool configFromOptions(const QCommandLineParser& p, const Options& o, MazeConfig& cfg){
+    bool okW=false, okH=false, okS=false, okT=false;
+    cfg.width = p.value(o.width).toInt(&okW);
+    cfg.height = p.value(o.height).toInt(&okH);
+    cfg.seed = p.value(o.seed).toULongLong(&okS);
+    cfg.threads = p.value(o.threads).toInt(&okT);
+    if (!okW || !okH || !okS || !okT || cfg.width <= 0 || cfg.height <= 0 || cfg.threads < 0){
+        err() << "Invalid size, seed or thread count" << Qt::endl;
+        return false;
+    }
+    cfg.algorithm = MazeIO::algorithmFromName(p.value(o.algorithm));
+    if (MazeIO::algorithmName(cfg.algorithm) != p.value(o.algorithm)){
+        err() << "Unknown algorithm: " << p.value(o.algorithm) << Qt::endl;
+        return false;
+    }
+    cfg.rng = MazeIO::rngFromName(p.value(o.rng));
+    if (MazeIO::rngName(cfg.rng) != p.value(o.rng)){
+        err() << "Unknown rng: " << p.value(o.rng) << Qt::endl;
+        return false;
+    }
+    return true;
+}
+
+// Loads the grid named by the first argument, or generates one from the options
+bool obtainGrid(const QCommandLineParser& p, const Options& o, const QStringList& args,
+                std::unique_ptr<MazeGrid>& grid, MazeConfig& cfg, QJsonObject& timings){
+    QElapsedTimer t; t.start();
+    if (!args.isEmpty() && p.isSet(o.region)){
+        MazeRect r{};
+        if (!parseRect(p.value(o.region), r)){ err() << "Invalid --region" << Qt::endl; return false; }
+        bool okT=false;
+        const int threads = p.isSet(o.threads) ? p.value(o.threads).toInt(&okT) : 0;
+        if (p.isSet(o.threads) && (!okT || threads < 0)){ err() << "Invalid thread count" << Qt::endl; return false; }
+        if (!MazeIO::readRegion(args.first(), r, grid, cfg, threads)){
+            err() << "Failed to read the region from " << args.first() << Qt::endl;
+            return false;
+        }
+        // A window is not what the seed generates
+        if (grid->width() != cfg.width || grid->height() != cfg.height){
+            cfg.width = grid->width();
+            cfg.height = grid->height();
+            cfg.seed = 0;
+        }
+        timings["load"] = msSince(t);
+        return true;
+    }
+    if (!args.isEmpty()){
+        if (!MazeIO::loadCreate(grid, cfg, args.first())){
+            err() << "Failed to load " << args.first() << Qt::endl;
+            return false;
+        }
+        timings["load"] = msSince(t);
+        return true;
+    }
+    if (!configFromOptions(p, o, cfg)) return false;
+    cfg.seed = MazeGenerator::resolveSeed(cfg.seed);
+    grid = std::make_unique<MazeGrid>(cfg.width, cfg.height);
+    MazeGenerator::generate(*grid, cfg);
+    timings["generate"] = msSince(t);
+    return true;
+}
+
+void report(bool asJson, const QJsonObject& result, const QString& text){
+    if (asJson) out() << QJsonDocument(result).toJson(QJsonDocument::Compact) << Qt::endl;
+    else out() << text << Qt::endl;
+}
+
+int cmdGenerate(const QCommandLineParser& p, const Options& o){
+    MazeConfig cfg;
+    if (!configFromOptions(p, o, cfg)) return 2;
+    bool okCount=false;
+    const qulonglong count = p.value(o.count).toULongLong(&okCount);
+    if (!okCount || count == 0){ err() << "Invalid --count" << Qt::endl; return 2; }
+
+    QJsonObject result{{"command", "generate"}, {"width", cfg.width}, {"height", cfg.height},
+                       {"algorithm", MazeIO::algorithmName(cfg.algorithm)}, {"rng", MazeIO::rngName(cfg.rng)},
+                       {"threads", cfg.threads}};
+    QJsonObject timings;
+
+    if (count > 1){
+        // Batch: consecutive seeds streamed to a binary file, one worker per thread
+        if (!p.isSet(o.output)){ err() << "--count requires --output" << Qt::endl; return 2; }
+        const uint64_t first = cfg.seed ? cfg.seed : 1;
+        std::ofstream f(p.value(o.output).toStdString(), std::ios::binary);
+        if (!f){ err() << "Cannot open " << p.value(o.output) << Qt::endl; return 1; }
+        MazeGenerator::BatchStats stats = MazeGenerator::generateBatch(cfg, first, count, f, cfg.threads);
+        f.close();
+        if (!f){ err() << "Failed to write " << p.value(o.output) << Qt::endl; return 1; }
+        timings["total"] = stats.seconds * 1e3;
+        result["firstSeed"] = QString::number(first);
+        result["mazes"] = double(stats.mazes);
+        result["mazesPerSecond"] = stats.mazesPerSecond;
+        result["timings_ms"] = timings;
+        report(p.isSet(o.json), result, QString("Generated %1 mazes in %2 s (%3 mazes/s)")
+               .arg(stats.mazes).arg(stats.seconds).arg(stats.mazesPerSecond, 0, 'f', 1));
+        return 0;
+    }
+
+    // A random seed is picked here rather than in the generator, so the
+    // report and the saved file name the seed that reproduces the maze
+    cfg.seed = MazeGenerator::resolveSeed(cfg.seed);
+    QElapsedTimer t; t.start();
+    MazeGrid grid(cfg.width, cfg.height);
+    timings["allocate"] = msSince(t);
+    t.restart();
+    MazeGenerator::generate(grid, cfg);
+    timings["generate"] = msSince(t);
+    if (p.isSet(o.output)){
+        t.restart();
+        if (!saveByExtension(grid, cfg, p.value(o.output), p.isSet(o.compact))) return 1;
+        timings["write"] = msSince(t);
+    }
+    result["seed"] = QString::number(cfg.seed);
+    result["timings_ms"] = timings;
+    report(p.isSet(o.json), result, QString("Generated %1x%2 maze in %3 ms")
+           .arg(cfg.width).arg(cfg.height).arg(timings["generate"].toDouble(), 0, 'f', 3));
+    return 0;
+}
+
+int cmdSolve(const QCommandLineParser& p, const Options& o, const QStringList& args){
+    std::unique_ptr<MazeGrid> grid; MazeConfig cfg; QJsonObject timings;
+    // .mzb input is solved straight from the file mapping, without loading
+    MazeIO::MappedMaze mapped;
+    MazeGridView view;
+    if (!args.isEmpty() && QFileInfo(args.first()).suffix().toLower() == "mzb"){
+        QElapsedTimer t; t.start();
+        if (!mapped.open(args.first())){ err() << "Failed to map " << args.first() << Qt::endl; return 1; }
+        timings["map"] = msSince(t);
+        view = mapped.view();
+    } else {
+        if (!obtainGrid(p, o, args, grid, cfg, timings)) return 1;
+        view = *grid;
+    }
+    Coord start{0, 0}, goal{view.width()-1, view.height()-1};
+    if ((p.isSet(o.start) && !parseCoord(p.value(o.start), start)) ||
+        (p.isSet(o.goal) && !parseCoord(p.value(o.goal), goal)) ||
+        !view.inBounds(start.x, start.y) || !view.inBounds(goal.x, goal.y)){
+        err() << "Invalid --start or --goal" << Qt::endl;
+        return 2;
+    }
+    const QString solverName = p.value(o.solver);
+    SolverAlgorithm alg = SolverAlgorithm::BFS;
+    if (solverName == "AStar") alg = SolverAlgorithm::AStar;
+    else if (solverName == "BidirectionalBFS") alg = SolverAlgorithm::BidirectionalBFS;
+    else if (solverName != "BFS"){ err() << "Unknown solver: " << solverName << Qt::endl; return 2; }
+
+    MazeSolver::Scratch scratch;
+    SolveStats stats;
+    QElapsedTimer t; t.start();
+    auto path = MazeSolver::solve(alg, view, start, goal, scratch, &stats);
+    timings["solve"] = msSince(t);
+
+    QJsonObject result{{"command", "solve"}, {"solver", solverName}, {"width", view.width()},
+                       {"height", view.height()}, {"found", bool(path)}, {"explored", double(stats.explored)},
+                       {"timings_ms", timings}};
+    if (path) result["length"] = int(path->nodes.size());
+    report(p.isSet(o.json), result, path
+           ? QString("Path of %1 cells found in %2 ms").arg(path->nodes.size()).arg(timings["solve"].toDouble(), 0, 'f', 3)
+           : QString("No path"));
+    return path ? 0 : 1;
+}
+
+// convert and export share the implementation; the output extension picks the
+// format. convert is meant for storage formats, export for renderings.
+int cmdWrite(const QCommandLineParser& p, const Options& o, const QStringList& args, const char* name){
+    if (args.size() != 2){ err() << name << " expects <input> <output>" << Qt::endl; return 2; }
+    std::unique_ptr<MazeGrid> grid; MazeConfig cfg; QJsonObject timings;
+    if (!obtainGrid(p, o, args.mid(0, 1), grid, cfg, timings)) return 1;
+    QElapsedTimer t; t.start();
+    if (!saveByExtension(*grid, cfg, args[1], p.isSet(o.compact))) return 1;
+    timings["write"] = msSince(t);
+    QJsonObject result{{"command", name}, {"width", grid->width()}, {"height", grid->height()},
+                       {"output", args[1]}, {"timings_ms", timings}};
+    report(p.isSet(o.json), result, QString("Wrote %1").arg(args[1]));
+    return 0;
+}
+
+// Groups identical mazes across files and batch files by wall fingerprint
+int cmdDedup(const QCommandLineParser& p, const Options& o, const QStringList& args){
+    if (args.isEmpty()){ err() << "dedup expects <file>..." << Qt::endl; return 2; }
+    bool okT=false;
+    const int threads = p.isSet(o.threads) ? p.value(o.threads).toInt(&okT) : 0;
+    if (p.isSet(o.threads) && (!okT || threads < 0)){ err() << "Invalid thread count" << Qt::endl; return 2; }
+    QElapsedTimer t; t.start();
+    const MazeFingerprint::DedupResult r = MazeFingerprint::findDuplicates(args, p.isSet(o.canonical), threads);
+    const double ms = msSince(t);
+
+    // Batch members are named file#index
+    auto name = [&](const MazeFingerprint::Entry& e){
+        return e.batch ? args[e.file] + QString("#%1").arg(e.index) : args[e.file];
+    };
+    uint64_t duplicates = 0;
+    QJsonArray groups;
+    QString text;
+    for (const MazeFingerprint::Group& g : r.groups){
+        duplicates += g.members.size() - 1;
+        QJsonArray members;
+        QStringList names;
+        for (const MazeFingerprint::Entry& e : g.members){ members.append(name(e)); names << name(e); }
+        const QString fp = QString("%1").arg(g.fingerprint, 16, 16, QChar('0'));
+        groups.append(QJsonObject{{"fingerprint", fp}, {"members", members}});
+        text += fp + ": " + names.join(", ") + "\n";
+    }
+    for (int file : r.failed) err() << "Failed to read " << args[file] << Qt::endl;
+    QJsonObject result{{"command", "dedup"}, {"canonical", p.isSet(o.canonical)}, {"mazes", double(r.mazes)},
+                       {"duplicates", double(duplicates)}, {"groups", groups},
+                       {"timings_ms", QJsonObject{{"total", ms}}}};
+    report(p.isSet(o.json), result, text + QString("%1 mazes, %2 duplicates in %3 groups (%4 ms)")
+           .arg(r.mazes).arg(duplicates).arg(r.groups.size()).arg(ms, 0, 'f', 1));
+    return r.failed.empty() ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]){
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("maze_cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Headless maze tool.\n"
+        "  generate [options]            generate a maze (or a batch with --count)\n"
+        "  solve [input] [options]       solve a loaded or freshly generated maze\n"
+        "  convert <input> <output>      re-encode a maze file\n"
+        "  export <input> <output>       render a maze as ASCII (.txt), SVG or PNG\n"
+        "  dedup <file>...               report duplicate mazes across files and batches");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "generate, solve, convert, export or dedup");
+    Options o;
+    parser.addOptions({o.width, o.height, o.seed, o.algorithm, o.rng, o.threads, o.count,
+                       o.output, o.start, o.goal, o.solver, o.region, o.compact, o.canonical, o.json});
+    parser.process(app);
+
+    QStringList args = parser.positionalArguments();
+    if (args.isEmpty()) parser.showHelp(2);
+    const QString cmd = args.takeFirst();
+    if (cmd == "generate") return cmdGenerate(parser, o);
+    if (cmd == "solve") return cmdSolve(parser, o, args);
+    if (cmd == "convert") return cmdWrite(parser, o, args, "convert");
+    if (cmd == "export") return cmdWrite(parser, o, args, "export");
+    if (cmd == "dedup") return cmdDedup(parser, o, args);
+    err() << "Unknown command: " << cmd << Qt::endl;
+    return 2;
+}
@@ -0,0 +1,58 @@
+#include "MazeGrid.h"
+#include "MazeGenerator.h"
+#include "MazeController.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+// Counts every heap allocation made by the process
+static std::atomic<long> gAllocations{0};
+
+void* operator new(std::size_t n) {
+    ++gAllocations;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main(){
+    const MazeAlgorithm algs[] = {MazeAlgorithm::RecursiveBacktracking, MazeAlgorithm::Prims,
+                                  MazeAlgorithm::Kruskal, MazeAlgorithm::Eller};
+    const MazeRng rngs[] = {MazeRng::Mt19937_64, MazeRng::Xoshiro256StarStar, MazeRng::Pcg64};
+    MazeGrid grid(120, 80);
+    MazeGenerator::Workspace ws;
+    for (MazeAlgorithm alg : algs) {
+        for (MazeRng rng : rngs) {
+            MazeConfig cfg; cfg.width=120; cfg.height=80; cfg.seed=99; cfg.algorithm=alg; cfg.rng=rng;
+            MazeGenerator::generate(grid, cfg, ws); // warm up the workspace
+            long before = gAllocations;
+            MazeGenerator::generate(grid, cfg, ws);
+            long count = gAllocations - before;
+            if (count != 0) {
+                std::cerr << "Generator allocated " << count << " times (algorithm " << int(alg)
+                          << ", rng " << int(rng) << ")" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    MazeConfig cfg; cfg.width=60; cfg.height=40; cfg.seed=5;
+    MazeController controller(cfg.width, cfg.height);
+    controller.startPreview(cfg);
+    MazeController::Changes changes;
+    controller.takeChanges(changes);
+    long before = gAllocations;
+    int steps = 0;
+    while (controller.stepPreview()) {
+        controller.takeChanges(changes);
+        ++steps;
+    }
+    if (gAllocations != before) {
+        std::cerr << "Preview allocated " << (gAllocations - before) << " times in " << steps << " steps" << std::endl;
+        return 1;
+    }
+    std::cout << "Allocation tests passed" << std::endl;
+    return 0;
+}
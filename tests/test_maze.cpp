@@ -1,7 +1,14 @@
 #include "MazeGrid.h"
 #include "MazeGenerator.h"
+#include "MazeSolver.h"
+#include "MazePathIndex.h"
+#include "MazeController.h"
+#include "MazeFingerprint.h"
+#include "MazeMesh.h"
 #include <iostream>
+#include <climits>
 #include <queue>
+#include <algorithm>
 
 // Check connectivity: BFS to count reachable cells
 int reachableCount(const MazeGrid& grid, int sx, int sy) {
@@ -26,7 +33,62 @@ int reachableCount(const MazeGrid& grid, int sx, int sy) {
     int count=0; for(bool b: vis) if(b) ++count; return count;
 }
 
+// Plain multi-source BFS distances for checking MazeSolver::distanceField
+std::vector<uint32_t> referenceDistances(const MazeGrid& grid, const std::vector<Coord>& sources) {
+    const int W = grid.width(), H = grid.height();
+    std::vector<uint32_t> d(size_t(W)*H, MazeSolver::kUnreachable);
+    std::queue<Coord> q;
+    for (const Coord& s : sources) { if (d[size_t(s.y)*W+s.x]) { d[size_t(s.y)*W+s.x] = 0; q.push(s); } }
+    while (!q.empty()) {
+        Coord c = q.front(); q.pop();
+        uint32_t nd = d[size_t(c.y)*W+c.x] + 1;
+        Coord next[4] = {{c.x,c.y-1},{c.x+1,c.y},{c.x,c.y+1},{c.x-1,c.y}};
+        bool open[4] = {!grid.wallN(c.x,c.y), !grid.wallE(c.x,c.y), !grid.wallS(c.x,c.y), !grid.wallW(c.x,c.y)};
+        for (int k=0; k<4; ++k) {
+            if (!open[k] || !grid.inBounds(next[k].x, next[k].y)) continue;
+            uint32_t& dn = d[size_t(next[k].y)*W+next[k].x];
+            if (dn == MazeSolver::kUnreachable) { dn = nd; q.push(next[k]); }
+        }
+    }
+    return d;
+}
+
+// A perfect maze has exactly cells-1 openings
+long openingCount(const MazeGrid& grid) {
+    long n = 0;
+    for (int y=0; y<grid.height(); ++y) for (int x=0; x<grid.width(); ++x) {
+        if (x+1 < grid.width() && !grid.wallE(x,y)) ++n;
+        if (y+1 < grid.height() && !grid.wallS(x,y)) ++n;
+    }
+    return n;
+}
+
+bool sameWalls(const MazeGrid& a, const MazeGrid& b) {
+    return a.hWallWords() == b.hWallWords() && a.vWallWords() == b.vWallWords();
+}
+
+// Shared-wall storage: removing a wall is visible from both sides, and the
+// word-level rows agree with the per-cell view
+bool checkSharedWalls() {
+    MazeGrid grid(70, 3);
+    grid.removeWallBetween({63,1}, {64,1});
+    grid.removeWallBetween({5,1}, {5,2});
+    if (grid.at(63,1).wallE || grid.at(64,1).wallW) return false;
+    if (grid.at(5,1).wallS || grid.at(5,2).wallN) return false;
+    if (!grid.at(64,1).wallE || !grid.at(5,1).wallN) return false;
+    if ((grid.vWallRow(1)[1] & 1u) != 0) return false;           // bit 64 of vertical row 1
+    if (((grid.hWallRow(2)[0] >> 5) & 1u) != 0) return false;    // bit 5 of horizontal row 2
+    if (grid.hWallRow(0)[1] != MazeGrid::tailMask(70)) return false; // padding stays clear
+    auto cell = grid.at(10,0);
+    cell.wallE = false;
+    return !grid.at(11,0).wallW;
+}
+
 int main(){
+    if(!checkSharedWalls()){
+        std::cerr << "Shared wall storage check failed" << std::endl;
+        return 1;
+    }
     MazeConfig cfg; cfg.width=30; cfg.height=20; cfg.seed=12345; cfg.algorithm=MazeAlgorithm::RecursiveBacktracking;
     MazeGrid grid(cfg.width,cfg.height);
     MazeGenerator::generate(grid, cfg);
@@ -38,10 +100,514 @@ int main(){
     cfg.algorithm=MazeAlgorithm::Prims;
     MazeGenerator::generate(grid, cfg);
     rc = reachableCount(grid, 0, 0);
-    if(rc != cfg.width*cfg.height){
+    if(rc != cfg.width*cfg.height || openingCount(grid) != long(cfg.width)*cfg.height-1){
         std::cerr << "Connectivity failed for Prim's: " << rc << " / " << (cfg.width*cfg.height) << std::endl;
         return 1;
     }
+
+    cfg.algorithm=MazeAlgorithm::Kruskal;
+    MazeGenerator::generate(grid, cfg);
+    rc = reachableCount(grid, 0, 0);
+    if(rc != cfg.width*cfg.height || openingCount(grid) != long(cfg.width)*cfg.height-1){
+        std::cerr << "Kruskal's is not a perfect maze: " << rc << " reachable" << std::endl;
+        return 1;
+    }
+    cfg.algorithm=MazeAlgorithm::Eller;
+    MazeGenerator::generate(grid, cfg);
+    rc = reachableCount(grid, 0, 0);
+    if(rc != cfg.width*cfg.height || openingCount(grid) != long(cfg.width)*cfg.height-1){
+        std::cerr << "Eller's is not a perfect maze: " << rc << " reachable" << std::endl;
+        return 1;
+    }
+    // The row stream matches the grid built from the same seed
+    MazeGrid streamed(cfg.width, cfg.height);
+    MazeGenerator::generateRows(cfg, [&](int y, const uint64_t* vWalls, const uint64_t* southWalls){
+        std::copy_n(vWalls, streamed.vWordsPerRow(), streamed.vWallRow(y));
+        std::copy_n(southWalls, streamed.hWordsPerRow(), streamed.hWallRow(y+1));
+    });
+    if(!sameWalls(grid, streamed)){
+        std::cerr << "Eller row stream differs from generate()" << std::endl;
+        return 1;
+    }
+
+    // Every engine drives every kernel to a perfect maze
+    for (MazeRng engine : {MazeRng::Xoshiro256StarStar, MazeRng::Pcg64}) {
+        cfg.rng = engine;
+        for (MazeAlgorithm alg : {MazeAlgorithm::RecursiveBacktracking, MazeAlgorithm::Prims, MazeAlgorithm::Eller, MazeAlgorithm::Kruskal}) {
+            cfg.algorithm = alg;
+            MazeGenerator::generate(grid, cfg);
+            if(reachableCount(grid, 0, 0) != cfg.width*cfg.height || openingCount(grid) != long(cfg.width)*cfg.height-1){
+                std::cerr << "Engine " << int(engine) << " failed for algorithm " << int(alg) << std::endl;
+                return 1;
+            }
+        }
+    }
+    cfg.rng = MazeRng::Mt19937_64;
+
+    // Tiled parallel generation stays perfect and deterministic per seed/thread count
+    cfg.width=300; cfg.height=170; cfg.threads=4;
+    for (MazeAlgorithm alg : {MazeAlgorithm::RecursiveBacktracking, MazeAlgorithm::Prims, MazeAlgorithm::Eller, MazeAlgorithm::Kruskal}) {
+        cfg.algorithm = alg;
+        MazeGrid a(cfg.width,cfg.height), b(cfg.width,cfg.height);
+        MazeGenerator::generate(a, cfg);
+        MazeGenerator::generate(b, cfg);
+        rc = reachableCount(a, 0, 0);
+        if(rc != cfg.width*cfg.height || openingCount(a) != long(cfg.width)*cfg.height-1){
+            std::cerr << "Tiled generation is not a perfect maze: " << rc << " reachable" << std::endl;
+            return 1;
+        }
+        if(!sameWalls(a, b)){
+            std::cerr << "Tiled generation is not deterministic" << std::endl;
+            return 1;
+        }
+    }
+
+    // Grids too large for one 32-bit indexed region are tiled even when serial,
+    // and the tiles cover the grid exactly
+    {
+        auto covers = [](const std::vector<MazeRect>& tiles, int w, int h) {
+            int64_t cells = 0;
+            for (const MazeRect& t : tiles) cells += int64_t(t.width) * t.height;
+            return cells == int64_t(w) * h;
+        };
+        for (MazeAlgorithm alg : {MazeAlgorithm::Prims, MazeAlgorithm::Kruskal}) {
+            for (int side : {50000, 100000}) {
+                const auto tiles = MazeGenerator::planTiles(side, side, alg, 1);
+                bool ok = tiles.size() > 1 && covers(tiles, side, side);
+                for (const MazeRect& t : tiles) ok = ok && int64_t(t.width) * t.height <= MazeGenerator::kMaxIndexedRegionCells;
+                if (!ok) {
+                    std::cerr << "Large grid is carved as an oversized region" << std::endl;
+                    return 1;
+                }
+            }
+            const auto wide = MazeGenerator::planTiles(INT_MAX - 1, 3, alg, 1);
+            if (!covers(wide, INT_MAX - 1, 3) || MazeGenerator::planTiles(4000, 4000, alg, 1).size() != 1) {
+                std::cerr << "Tile planning is wrong" << std::endl;
+                return 1;
+            }
+        }
+        if (MazeGenerator::planTiles(50000, 50000, MazeAlgorithm::RecursiveBacktracking, 1).size() != 1) {
+            std::cerr << "Serial backtracking should not be tiled" << std::endl;
+            return 1;
+        }
+    }
+
+    // Batch generation matches serial generation seed by seed, in seed order
+    cfg.width=40; cfg.height=25; cfg.threads=1; cfg.algorithm=MazeAlgorithm::Prims;
+    uint64_t expectSeed = 100;
+    bool batchOk = true;
+    MazeGenerator::BatchStats stats = MazeGenerator::generateBatch(cfg, 100, 24, [&](uint64_t seed, const MazeGrid& g){
+        MazeConfig one = cfg; one.seed = seed;
+        MazeGrid ref(cfg.width, cfg.height);
+        MazeGenerator::generate(ref, one);
+        if (seed != expectSeed++ || !sameWalls(g, ref)) batchOk = false;
+    }, 3);
+    if(!batchOk || stats.mazes != 24 || expectSeed != 124){
+        std::cerr << "Batch generation differs from serial generation" << std::endl;
+        return 1;
+    }
+
+    // A resolved random seed is concrete and regenerates the same maze
+    {
+        MazeConfig rc = cfg; rc.seed = MazeGenerator::resolveSeed(0);
+        MazeGrid first(rc.width, rc.height), again(rc.width, rc.height);
+        MazeGenerator::generate(first, rc);
+        MazeGenerator::generate(again, rc);
+        if (rc.seed == 0 || MazeGenerator::resolveSeed(rc.seed) != rc.seed || !sameWalls(first, again)) {
+            std::cerr << "Resolved seed does not reproduce the maze" << std::endl;
+            return 1;
+        }
+    }
+
+    // A* and bidirectional BFS find shortest paths, also on mazes with loops,
+    // and reuse one scratch across calls
+    {
+        MazeConfig lc; lc.width=37; lc.height=23; lc.seed=5;
+        MazeGrid lg(lc.width, lc.height);
+        MazeGenerator::generate(lg, lc);
+        std::mt19937 pick(11);
+        for (int k=0; k<150; ++k) {
+            int x = int(pick() % unsigned(lc.width-1)), y = int(pick() % unsigned(lc.height));
+            lg.removeWallBetween({x,y}, {x+1,y});
+        }
+        MazeSolver::Scratch scratch;
+        for (int k=0; k<200; ++k) {
+            Coord a{int(pick() % unsigned(lc.width)), int(pick() % unsigned(lc.height))};
+            Coord b{int(pick() % unsigned(lc.width)), int(pick() % unsigned(lc.height))};
+            auto ref = MazeSolver::solveBFS(lg, a, b);
+            for (SolverAlgorithm alg : {SolverAlgorithm::AStar, SolverAlgorithm::BidirectionalBFS}) {
+                SolveStats st;
+                auto p = MazeSolver::solve(alg, lg, a, b, scratch, &st);
+                bool ok = ref && p && p->nodes.size() == ref->nodes.size() && st.explored > 0;
+                for (size_t i=1; ok && i<p->nodes.size(); ++i) {
+                    Coord u = p->nodes[i-1], v = p->nodes[i];
+                    Cell c = lg.at(u.x,u.y);
+                    ok = (v.x==u.x+1 && v.y==u.y && !c.wallE) || (v.x==u.x-1 && v.y==u.y && !c.wallW) ||
+                         (v.y==u.y+1 && v.x==u.x && !c.wallS) || (v.y==u.y-1 && v.x==u.x && !c.wallN);
+                }
+                if (!ok || p->nodes.front().x != a.x || p->nodes.front().y != a.y ||
+                    p->nodes.back().x != b.x || p->nodes.back().y != b.y) {
+                    std::cerr << "Solver " << int(alg) << " returned a wrong path" << std::endl;
+                    return 1;
+                }
+            }
+        }
+    }
+
+    // Distance fields match a plain BFS: sparse levels on a maze with several
+    // sources, dense (and threaded) levels on a maze opened up into a field
+    {
+        MazeConfig dc; dc.width=131; dc.height=77; dc.seed=21; dc.algorithm=MazeAlgorithm::Kruskal;
+        MazeGrid dg(dc.width, dc.height);
+        MazeGenerator::generate(dg, dc);
+        std::vector<Coord> src = {{0,0}, {130,76}, {64,40}, {64,40}};
+        std::vector<uint32_t> field(size_t(dc.width)*dc.height);
+        uint32_t maxD = MazeSolver::distanceField(dg, src, field.data());
+        std::vector<uint32_t> ref = referenceDistances(dg, src);
+        if (field != ref || maxD != *std::max_element(ref.begin(), ref.end())) {
+            std::cerr << "Distance field differs from BFS" << std::endl;
+            return 1;
+        }
+
+        MazeGrid og(4100, 1024);
+        dc.width = og.width(); dc.height = og.height(); dc.algorithm = MazeAlgorithm::Eller;
+        MazeGenerator::generate(og, dc);
+        for (int y=0; y<og.height(); ++y)
+            for (int x=0; x+1<og.width(); ++x)
+                if ((x*7 + y*13) % 5) og.removeWallBetween({x,y}, {x+1,y});
+        for (int y=0; y+1<og.height(); ++y)
+            for (int x=0; x<og.width(); ++x)
+                if ((x*11 + y*3) % 4) og.removeWallBetween({x,y}, {x,y+1});
+        // A lattice of sources gives frontiers wide enough for dense levels
+        src.clear();
+        for (int y=0; y<og.height(); y+=8)
+            for (int x=0; x<og.width(); x+=8) src.push_back({x,y});
+        ref = referenceDistances(og, src);
+        for (int threads : {1, 4}) {
+            field.assign(ref.size(), 0);
+            MazeSolver::distanceField(og, src, field.data(), threads);
+            if (field != ref) {
+                std::cerr << "Dense distance field differs from BFS (threads " << threads << ")" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    // The path index agrees with BFS on perfect mazes and rejects mazes with loops
+    for (MazeAlgorithm alg : {MazeAlgorithm::RecursiveBacktracking, MazeAlgorithm::Kruskal}) {
+        MazeConfig pc; pc.width=97; pc.height=61; pc.seed=77; pc.algorithm=alg;
+        MazeGrid pg(pc.width, pc.height);
+        MazeGenerator::generate(pg, pc);
+        MazePathIndex index(pg);
+        if (!index.valid()) { std::cerr << "Path index rejected a perfect maze" << std::endl; return 1; }
+        std::mt19937 pick(3);
+        std::vector<Coord> nodes;
+        for (int k=0; k<300; ++k) {
+            Coord a{int(pick() % unsigned(pc.width)), int(pick() % unsigned(pc.height))};
+            Coord b{int(pick() % unsigned(pc.width)), int(pick() % unsigned(pc.height))};
+            auto ref = MazeSolver::solveBFS(pg, a, b);
+            index.path(a, b, nodes);
+            bool same = ref && nodes.size() == ref->nodes.size() && index.distance(a, b) + 1 == nodes.size();
+            for (size_t i=0; same && i<nodes.size(); ++i)
+                same = nodes[i].x == ref->nodes[i].x && nodes[i].y == ref->nodes[i].y;
+            if (!same) { std::cerr << "Path index disagrees with BFS" << std::endl; return 1; }
+        }
+        pg.removeWallBetween({10,10}, {11,10});
+        pg.removeWallBetween({10,11}, {11,11});
+        pg.removeWallBetween({10,10}, {10,11});
+        pg.removeWallBetween({11,10}, {11,11});
+        if (index.build(pg) || index.valid()) { std::cerr << "Path index accepted a maze with loops" << std::endl; return 1; }
+    }
+    // The wall hash follows every removal incrementally and matches a full
+    // rehash; the controller's solve cache hits on repeats and misses once the
+    // walls change
+    {
+        MazeConfig hc; hc.width=75; hc.height=40; hc.seed=5; hc.algorithm=MazeAlgorithm::Prims;
+        MazeController controller(hc.width, hc.height);
+        controller.regenerate(hc);
+        MazeGrid hg = controller.grid();
+        const uint64_t before = hg.wallHash();
+        hg.removeWallBetween({70,3}, {70,4});
+        hg.removeWallBetween({63,9}, {64,9});
+        MazeGrid rehashed = hg;
+        rehashed.hWallRow(0);
+        if (hg.wallHash() == before || hg.wallHash() != rehashed.wallHash()) {
+            std::cerr << "Incremental wall hash is wrong" << std::endl;
+            return 1;
+        }
+        SolveStats st;
+        const Coord s{0,0}, t{hc.width-1, hc.height-1};
+        auto first = controller.solve(SolverAlgorithm::BFS, s, t, &st);
+        auto again = controller.solve(SolverAlgorithm::BFS, s, t, &st);
+        const MazeSolveCache& cache = controller.solveCache();
+        if (!first || !again || again->nodes.size() != first->nodes.size() || st.explored != 0 ||
+            cache.hits() != 1 || cache.misses() != 1) {
+            std::cerr << "Solve cache missed a repeated query" << std::endl;
+            return 1;
+        }
+        controller.applyFromGrid(hg);
+        controller.solve(SolverAlgorithm::BFS, s, t, &st);
+        if (cache.misses() != 2 || st.explored == 0) {
+            std::cerr << "Solve cache returned a result for changed walls" << std::endl;
+            return 1;
+        }
+
+        // A budget of two entries keeps the two most recently used
+        MazeSolveCache small(2 * (96 + first->nodes.size() * sizeof(Coord)));
+        for (int i=0; i<3; ++i) small.store({before, s, {i,0}, SolverAlgorithm::BFS}, first);
+        std::optional<MazePath> out;
+        if (small.entries() != 2 || small.lookup({before, s, {0,0}, SolverAlgorithm::BFS}, out) ||
+            !small.lookup({before, s, {2,0}, SolverAlgorithm::BFS}, out)) {
+            std::cerr << "Solve cache eviction is wrong" << std::endl;
+            return 1;
+        }
+    }
+    // Incremental re-solving tracks BFS through wall edits and preview steps
+    {
+        MazeConfig ic; ic.width=60; ic.height=45; ic.seed=8; ic.algorithm=MazeAlgorithm::Kruskal;
+        MazeController controller(ic.width, ic.height);
+        controller.regenerate(ic);
+        const Coord s{3,4}, t{ic.width-2, ic.height-1};
+        MazeSolver::Scratch scratch;
+        std::mt19937 pick(11);
+        auto agrees = [&](const std::optional<MazePath>& p) {
+            auto ref = MazeSolver::solveBFS(controller.grid(), s, t, scratch);
+            return bool(p) == bool(ref) && (!p || p->nodes.size() == ref->nodes.size());
+        };
+        for (int k=0; k<400; ++k) {
+            const int x = int(pick() % unsigned(ic.width-1)), y = int(pick() % unsigned(ic.height-1));
+            const Coord a{x,y}, b = (pick() & 1) ? Coord{x+1,y} : Coord{x,y+1};
+            controller.setWall(a, b, b.x != x ? !controller.grid().wallE(x,y) : !controller.grid().wallS(x,y));
+            if (!agrees(controller.trackPath(s, t))) {
+                std::cerr << "Incremental solver disagrees with BFS after a wall edit" << std::endl;
+                return 1;
+            }
+        }
+        controller.startPreview(ic);
+        for (int k=0; controller.previewActive(); ++k) {
+            if (k % 97 == 0 && !agrees(controller.trackPath(s, t))) {
+                std::cerr << "Incremental solver disagrees with BFS during preview" << std::endl;
+                return 1;
+            }
+            controller.stepPreview();
+        }
+        if (!agrees(controller.trackPath(s, t)) || !controller.trackPath(s, t)) {
+            std::cerr << "Incremental solver missed the finished preview maze" << std::endl;
+            return 1;
+        }
+    }
+    // Fingerprints: the eight symmetries move every wall to its image cell,
+    // and the canonical hash is the same for all of them but not for another maze
+    {
+        MazeConfig fc; fc.width=70; fc.height=9; fc.seed=21;
+        MazeGrid fg(fc.width, fc.height);
+        MazeGenerator::generate(fg, fc);
+        const uint64_t canon = MazeFingerprint::canonicalHash(fg);
+        for (int sym=0; sym<MazeFingerprint::kSymmetries; ++sym) {
+            const MazeGrid t = MazeFingerprint::transformed(fg, sym);
+            const bool swap = sym & 4;
+            if (t.width() != (swap ? fc.height : fc.width) || t.height() != (swap ? fc.width : fc.height)) {
+                std::cerr << "Transformed maze has the wrong size" << std::endl;
+                return 1;
+            }
+            for (int y=0; y<t.height(); ++y)
+                for (int x=0; x<t.width(); ++x) {
+                    // Walls of (x,y) seen from the original cell, undoing mirrors then the transpose
+                    bool n=t.wallN(x,y), e=t.wallE(x,y), so=t.wallS(x,y), w=t.wallW(x,y);
+                    int ox = (sym & 1) ? t.width()-1-x : x, oy = (sym & 2) ? t.height()-1-y : y;
+                    if (sym & 1) std::swap(e, w);
+                    if (sym & 2) std::swap(n, so);
+                    if (swap) { std::swap(ox, oy); std::swap(n, w); std::swap(e, so); }
+                    if (n != fg.wallN(ox,oy) || e != fg.wallE(ox,oy) || so != fg.wallS(ox,oy) || w != fg.wallW(ox,oy)) {
+                        std::cerr << "Symmetry " << sym << " misplaces walls at " << x << "," << y << std::endl;
+                        return 1;
+                    }
+                }
+            if (MazeFingerprint::canonicalHash(t) != canon || (sym && MazeFingerprint::hash(t) == MazeFingerprint::hash(fg))) {
+                std::cerr << "Fingerprint of symmetry " << sym << " is wrong" << std::endl;
+                return 1;
+            }
+        }
+        MazeGrid other = fg;
+        if (fg.wallE(0,0)) other.removeWallBetween({0,0}, {1,0});
+        else other.addWallBetween({0,0}, {1,0});
+        if (MazeFingerprint::hash(other) == MazeFingerprint::hash(fg) || MazeFingerprint::canonicalHash(other) == canon) {
+            std::cerr << "Fingerprint ignores a wall change" << std::endl;
+            return 1;
+        }
+    }
+    // Mesh: each wall is covered by exactly one wall instance and open edges
+    // by none, collinear walls share instances, every triangle winds
+    // counter-clockwise seen from its normal, and chunk indices stay within
+    // their chunk
+    {
+        MazeConfig mc; mc.width=70; mc.height=33; mc.seed=5; mc.algorithm=MazeAlgorithm::Prims;
+        MazeGrid mg(mc.width, mc.height);
+        MazeGenerator::generate(mg, mc);
+        MazeMesh::Mesh mesh;
+        MazeMesh::buildMaze(mg, mesh);
+        const int W = mc.width, H = mc.height, S = MazeMesh::kPositionScale;
+        const int normals[6][3] = {{1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,1}, {0,0,-1}};
+        auto windsOut = [&](const int (&p)[3][3], const MazeVertex& v0) {
+            const int* n = normals[v0.normal % 6];
+            long long e1[3], e2[3];
+            for (int k=0; k<3; ++k) { e1[k] = p[1][k]-p[0][k]; e2[k] = p[2][k]-p[0][k]; }
+            const long long cross[3] = {e1[1]*e2[2]-e1[2]*e2[1], e1[2]*e2[0]-e1[0]*e2[2], e1[0]*e2[1]-e1[1]*e2[0]};
+            return cross[0]*n[0] + cross[1]*n[1] + cross[2]*n[2] > 0;
+        };
+        bool wound = sizeof(MazeVertex) == 8 && sizeof(MazeWallInstance) == 4, indexed = true;
+        const MazeVertex* unit = MazeMesh::unitWall();
+        for (int i=0; i<MazeMesh::kUnitWallVertices; i+=3) {
+            int p[3][3];
+            for (int t=0; t<3; ++t) for (int k=0; k<3; ++k) p[t][k] = unit[i+t].pos[k];
+            wound = wound && windsOut(p, unit[i]) && (unit[i].normal == MazeMesh::PosZ) == (i < 6);
+        }
+        std::vector<int> hFaces(size_t(H+1)*W), vFaces(size_t(H)*(W+1));
+        for (const MazeMesh::Chunk& c : mesh.chunks) {
+            indexed = indexed && c.indexCount % 6 == 0 && c.firstVertex + c.vertexCount <= mesh.vertices.size();
+            for (uint32_t i = 0; indexed && i < c.indexCount; i += 3) {
+                int p[3][3];
+                for (int t=0; t<3; ++t) {
+                    const uint16_t idx = mesh.indices[c.firstIndex + i + t];
+                    indexed = indexed && idx < c.vertexCount;
+                    const MazeVertex& v = mesh.vertices[c.firstVertex + (idx < c.vertexCount ? idx : 0)];
+                    p[t][0] = c.originX*S + v.pos[0]; p[t][1] = v.pos[1]; p[t][2] = c.originZ*S + v.pos[2];
+                }
+                wound = wound && windsOut(p, mesh.vertices[c.firstVertex + mesh.indices[c.firstIndex + i]]);
+            }
+            for (uint32_t i = 0; i < c.wallCount; ++i) {
+                const MazeWallInstance& w = mesh.walls[c.firstWall + i];
+                const int x = c.originX + w.x, z = c.originZ + w.z;
+                for (int k=0; k<w.length; ++k) {
+                    if (w.axis == MazeMesh::AlongX && z <= H && x + k < W) hFaces[size_t(z)*W + x + k]++;
+                    else if (w.axis == MazeMesh::AlongZ && x <= W && z + k < H) vFaces[size_t(z + k)*(W+1) + x]++;
+                    else indexed = false;
+                }
+            }
+        }
+        size_t walls = 0;
+        bool covered = true;
+        for (int r=0; r<=H; ++r)
+            for (int x=0; x<W; ++x) {
+                const int want = r < H ? mg.wallN(x, r) : mg.wallS(x, H-1);
+                walls += size_t(want);
+                covered = covered && hFaces[size_t(r)*W + x] == want;
+            }
+        for (int y=0; y<H; ++y)
+            for (int x=0; x<=W; ++x) {
+                const int want = x < W ? mg.wallW(x, y) : mg.wallE(W-1, y);
+                walls += size_t(want);
+                covered = covered && vFaces[size_t(y)*(W+1) + x] == want;
+            }
+        size_t runs = 0;
+        for (const MazeMesh::Chunk& c : mesh.chunks) runs += c.wallCount;
+        const bool quads = mesh.vertices.size() * 6 == mesh.indices.size() * 4;
+        if (!wound || !indexed || !covered || !quads || runs >= walls) {
+            std::cerr << "Maze mesh is wrong (" << runs << " runs for " << walls << " walls)" << std::endl;
+            return 1;
+        }
+        // Path markers land in the chunk of their cell
+        MazeMesh::appendPath({{0,0}, {69,32}, {40,5}, {41,5}}, mesh);
+        const MazeMesh::Chunk& last = mesh.chunks.back();
+        if (mesh.indices.size() * 4 != mesh.vertices.size() * 6 || last.originX != 64 || last.originZ != 32 ||
+            last.vertexCount != 4 || mesh.vertices[last.firstVertex].material != MazeMesh::PathMarker ||
+            mesh.vertices[last.firstVertex].pos[0] != 5*S + 15) {
+            std::cerr << "Path markers are misplaced" << std::endl;
+            return 1;
+        }
+    }
+    // Controller change reports: patching the chunks of the reported cells
+    // gives the same walls as a full rebuild, through edits and preview steps
+    {
+        MazeConfig cc; cc.width=75; cc.height=40; cc.seed=21; cc.algorithm=MazeAlgorithm::Eller;
+        MazeController controller(cc.width, cc.height);
+        controller.regenerate(cc);
+        MazeMesh::Mesh patched, fresh;
+        MazeMesh::buildMaze(controller.grid(), patched);
+        MazeController::Changes changes;
+        controller.takeChanges(changes);
+        const bool first = changes.all;
+        controller.takeChanges(changes);
+        if (!first || changes.all) {
+            std::cerr << "Regenerating should report a full change once" << std::endl;
+            return 1;
+        }
+        auto sameWalls = [&]() {
+            MazeMesh::buildMaze(controller.grid(), fresh);
+            for (size_t i=0; i<fresh.chunks.size(); ++i) {
+                const MazeMesh::Chunk &p = patched.chunks[i], &f = fresh.chunks[i];
+                if (p.wallCount != f.wallCount) return false;
+                for (uint32_t k=0; k<f.wallCount; ++k) {
+                    const MazeWallInstance &a = patched.walls[p.firstWall + k], &b = fresh.walls[f.firstWall + k];
+                    if (a.x != b.x || a.z != b.z || a.length != b.length || a.axis != b.axis) return false;
+                }
+            }
+            return true;
+        };
+        auto patch = [&]() {
+            controller.takeChanges(changes);
+            if (changes.all) return false;
+            for (const Coord& c : changes.cells)
+                MazeMesh::rebuildWalls(controller.grid(), patched, MazeMesh::chunkAt(controller.grid(), c.x, c.y));
+            return true;
+        };
+        std::mt19937 pick(4);
+        bool ok = true;
+        for (int k=0; k<300 && ok; ++k) {
+            // Biased toward chunk edges and the maze boundary
+            const int x = (pick() & 1) ? int(pick() % 3) * 32 + 31 - int(pick() & 1) : int(pick() % unsigned(cc.width-1));
+            const int y = int(pick() % unsigned(cc.height-1));
+            const Coord a{std::min(x, cc.width-2), y}, b = (pick() & 1) ? Coord{a.x+1,y} : Coord{a.x,y+1};
+            controller.setWall(a, b, (pick() & 1) != 0);
+            ok = patch() && (k % 10 || sameWalls());
+        }
+        controller.startPreview(cc);
+        MazeMesh::buildMaze(controller.grid(), patched);
+        controller.takeChanges(changes);
+        ok = ok && changes.all;
+        for (int k=0; ok && controller.previewActive(); ++k) {
+            controller.stepPreview();
+            ok = patch() && (k % 500 || sameWalls());
+        }
+        if (!ok || !sameWalls()) {
+            std::cerr << "Patched mesh walls differ from a full rebuild" << std::endl;
+            return 1;
+        }
+        // Unread changes fall back to a full change once they outnumber the chunks
+        for (int k=0; k<cc.width-1; ++k) controller.setWall({k,0}, {k+1,0}, true);
+        controller.takeChanges(changes);
+        if (!changes.all || !changes.cells.empty()) {
+            std::cerr << "Change list grew past the chunk count" << std::endl;
+            return 1;
+        }
+    }
+    // Frustum culling of chunk bounding boxes
+    {
+        MazeGrid fg(100, 70);
+        MazeMesh::Mesh mesh;
+        MazeMesh::buildMaze(fg, mesh);
+        const MazeMesh::Chunk& last = mesh.chunks.back();
+        bool ok = mesh.chunks.size() == 12 && last.cellsX == 4 && last.cellsZ == 6;
+        // Orthographic view of x in [40, 60], z in [0, 10] from above: clip x
+        // from world x, clip y from world z, clip z from world y (column-major)
+        const float ortho[16] = {0.1f, 0, 0, 0,   0, 0, 0.5f, 0,   0, 0.2f, 0, 0,   -5.0f, -1.0f, -0.5f, 1.0f};
+        const MazeMesh::Frustum top(ortho);
+        for (size_t i = 0; i < mesh.chunks.size(); ++i)
+            ok = ok && top.intersects(mesh.chunks[i]) == (i == 1);
+        // Perspective from (50, 1, 50) looking down -z (90 degree fov, near
+        // 0.1, far 100): only the chunks north of the camera are drawn
+        const float n = 0.1f, f = 100.0f, a = (f + n) / (n - f), b = 2 * f * n / (n - f);
+        const float persp[16] = {1, 0, 0, 0,   0, 1, 0, 0,   0, 0, a, -1,   -50.0f, -1.0f, -50.0f * a + b, 50.0f};
+        const MazeMesh::Frustum ahead(persp);
+        const float behind[3] = {40, 0, 60}, behindHi[3] = {60, 1.8f, 65};
+        const float front[3] = {40, 0, 30}, frontHi[3] = {60, 1.8f, 35};
+        ok = ok && !ahead.intersects(behind, behindHi) && ahead.intersects(front, frontHi) &&
+             ahead.intersects(mesh.chunks[1]) && !ahead.intersects(mesh.chunks[10]);
+        if (!ok) {
+            std::cerr << "Frustum culling is wrong" << std::endl;
+            return 1;
+        }
+    }
     std::cout << "All tests passed" << std::endl;
     return 0;
 }
@@ -1,9 +1,19 @@
 #include "MazeGrid.h"
 #include "MazeGenerator.h"
 #include "MazeIO.h"
+#include "MazeIOJob.h"
+#include "MazeFingerprint.h"
+#include "MazeRaster.h"
+#include "MazeSolver.h"
 #include <QString>
+#include <QFile>
+#include <QtEndian>
+#include <algorithm>
+#include <climits>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <tuple>
 
 int main(){
     MazeConfig cfg; cfg.width=15; cfg.height=10; cfg.seed=42; cfg.algorithm=MazeAlgorithm::Prims;
@@ -22,6 +32,303 @@ int main(){
             }
         }
     }
+
+    // Compact bitmask encoding
+    if (!MazeIO::saveToJson(grid, cfg, path, MazeIO::JsonEncoding::Bitmask) ||
+        !MazeIO::loadCreate(loaded, cfg2, path) || loaded->hWallWords() != grid.hWallWords() ||
+        loaded->vWallWords() != grid.vWallWords() || cfg2.seed != cfg.seed) {
+        std::cerr << "Bitmask JSON roundtrip mismatch" << std::endl; return 1;
+    }
+
+    // Members in any order (cells before the size, as QJsonDocument sorts them),
+    // a seed written as a double and unknown members; truncated files fail
+    {
+        const QByteArray text =
+            "{\"algorithm\": \"Eller\", \"cells\": [\n"
+            "  {\"visited\": true, \"wallE\": false, \"wallN\": true, \"wallS\": true, \"wallW\": true},\n"
+            "  {\"wallE\": true, \"wallN\": true, \"wallS\": false, \"wallW\": false},\n"
+            "  {\"wallN\": true, \"wallE\": false, \"wallW\": true},\n"
+            "  {\"wallE\": true, \"wallN\": false, \"wallS\": true, \"wallW\": false, \"note\": [1, {\"x\": null}]}],\n"
+            " \"height\": 2, \"rng\": \"Pcg64\", \"seed\": 12345.0, \"width\": 2, \"extra\": \"a\\\"b\"}";
+        QFile f(path);
+        if (!f.open(QIODevice::WriteOnly) || f.write(text) != text.size()) { std::cerr << "Write failed" << std::endl; return 1; }
+        f.close();
+        if (!MazeIO::loadCreate(loaded, cfg2, path) || loaded->width() != 2 || loaded->height() != 2 ||
+            cfg2.seed != 12345 || cfg2.algorithm != MazeAlgorithm::Eller || cfg2.rng != MazeRng::Pcg64 ||
+            loaded->wallE(0,0) || loaded->wallS(1,0) || !loaded->wallS(0,0) || !loaded->wallS(0,1) ||
+            !loaded->wallE(1,1)) {
+            std::cerr << "Unordered JSON parsed wrong" << std::endl; return 1;
+        }
+        if (!f.open(QIODevice::WriteOnly) || f.write(text.left(text.size() / 2)) != text.size() / 2) { std::cerr << "Write failed" << std::endl; return 1; }
+        f.close();
+        if (MazeIO::loadCreate(loaded, cfg2, path)) { std::cerr << "Truncated JSON accepted" << std::endl; return 1; }
+
+        // Unknown members may nest, but not without limit
+        const int cut = int(text.indexOf("\"extra\""));
+        auto nested = [&](int depth) {
+            return text.left(cut) + "\"deep\": " + QByteArray(depth, '[') + QByteArray(depth, ']') + ", " + text.mid(cut);
+        };
+        if (!f.open(QIODevice::WriteOnly) || f.write(nested(100)) <= 0) { std::cerr << "Write failed" << std::endl; return 1; }
+        f.close();
+        if (!MazeIO::loadCreate(loaded, cfg2, path)) { std::cerr << "Nested unknown member rejected" << std::endl; return 1; }
+        if (!f.open(QIODevice::WriteOnly) || f.write(nested(1000000)) <= 0) { std::cerr << "Write failed" << std::endl; return 1; }
+        f.close();
+        if (MazeIO::loadCreate(loaded, cfg2, path)) { std::cerr << "Deeply nested JSON accepted" << std::endl; return 1; }
+
+        // A size the file is too short to hold is rejected, not allocated
+        if (!f.open(QIODevice::WriteOnly) || f.write("{\"width\": 2147483647, \"height\": 2147483647, \"cellMasks\": []}") <= 0) {
+            std::cerr << "Write failed" << std::endl; return 1;
+        }
+        f.close();
+        if (MazeIO::loadCreate(loaded, cfg2, path)) { std::cerr << "Oversized JSON accepted" << std::endl; return 1; }
+    }
+
+    // Binary .mzb: loadCreate recognises it, and a mapped view reads the same walls
+    QString binPath = "/mnt/data/maze3d/build/test_maze.mzb";
+    cfg.width = 130; cfg.height = 7; cfg.algorithm = MazeAlgorithm::Kruskal; cfg.rng = MazeRng::Pcg64;
+    MazeGrid wide(cfg.width, cfg.height);
+    MazeGenerator::generate(wide, cfg);
+    if (!MazeIO::saveBinary(wide, cfg, binPath)) { std::cerr << "Binary save failed" << std::endl; return 1; }
+    if (!MazeIO::loadCreate(loaded, cfg2, binPath) || loaded->hWallWords() != wide.hWallWords() ||
+        loaded->vWallWords() != wide.vWallWords() || cfg2.seed != cfg.seed || cfg2.rng != cfg.rng ||
+        cfg2.algorithm != cfg.algorithm) {
+        std::cerr << "Binary roundtrip mismatch" << std::endl; return 1;
+    }
+    MazeIO::MappedMaze mapped;
+    if (!mapped.open(binPath)) { std::cerr << "Binary map failed" << std::endl; return 1; }
+    const MazeGridView& view = mapped.view();
+    for (int y=0; y<wide.height(); ++y)
+        for (int x=0; x<wide.width(); ++x)
+            if (view.wallN(x,y) != wide.wallN(x,y) || view.wallE(x,y) != wide.wallE(x,y) ||
+                view.wallS(x,y) != wide.wallS(x,y) || view.wallW(x,y) != wide.wallW(x,y)) {
+                std::cerr << "Mapped wall mismatch at " << x << "," << y << std::endl; return 1;
+            }
+    auto viaView = MazeSolver::solveBFS(view, {0,0}, {cfg.width-1, cfg.height-1});
+    auto viaGrid = MazeSolver::solveBFS(wide, {0,0}, {cfg.width-1, cfg.height-1});
+    if (!viaView || !viaGrid || viaView->nodes.size() != viaGrid->nodes.size()) {
+        std::cerr << "Solve on mapped view differs" << std::endl; return 1;
+    }
+    mapped.close();
+
+    // Compact .mzc: a seeded maze is just its header, edits become a short diff,
+    // and unseeded or hand-made walls go through the entropy coder
+    QString mzcPath = "/mnt/data/maze3d/build/test_maze.mzc";
+    auto compactRoundtrip = [&](const MazeGrid& g, const MazeConfig& c) {
+        return MazeIO::saveCompact(g, c, mzcPath) && MazeIO::loadCreate(loaded, cfg2, mzcPath) &&
+               loaded->hWallWords() == g.hWallWords() && loaded->vWallWords() == g.vWallWords() &&
+               cfg2.seed == c.seed && cfg2.algorithm == c.algorithm && cfg2.rng == c.rng;
+    };
+    auto fileSize = [&]() { return QFile(mzcPath).size(); };
+    if (!compactRoundtrip(wide, cfg) || fileSize() != 49) {
+        std::cerr << "Compact replay roundtrip mismatch (" << fileSize() << " bytes)" << std::endl; return 1;
+    }
+    wide.addWallBetween({3,3}, {4,3});
+    wide.removeWallBetween({129,0}, {129,1});
+    if (!compactRoundtrip(wide, cfg) || fileSize() > 56) {
+        std::cerr << "Compact diff roundtrip mismatch (" << fileSize() << " bytes)" << std::endl; return 1;
+    }
+    MazeConfig unseeded = cfg; unseeded.seed = 0;
+    if (!compactRoundtrip(wide, unseeded) || fileSize() >= 48 + qint64(wide.hWallWords().size() + wide.vWallWords().size()) * 8) {
+        std::cerr << "Compact coded roundtrip mismatch (" << fileSize() << " bytes)" << std::endl; return 1;
+    }
+    MazeGrid open(9, 5); // no generator: walls off inside, a few boundary gaps
+    for (int y=0; y<open.height(); ++y)
+        for (int x=0; x+1<open.width(); ++x) open.removeWallBetween({x,y}, {x+1,y});
+    open.at(0,0).wallW = false; open.at(8,4).wallS = false;
+    if (!compactRoundtrip(open, unseeded)) { std::cerr << "Compact coded roundtrip mismatch (open)" << std::endl; return 1; }
+    // Crafted headers whose size the payload cannot hold fail without allocating
+    // the grid; a replay too large for memory fails instead of throwing
+    auto craftMzc = [&](quint32 w, quint32 h, quint32 mode, size_t payload) {
+        QFile src(mzcPath);
+        QByteArray bytes = src.open(QIODevice::ReadOnly) ? src.read(48) : QByteArray();
+        src.close();
+        uchar* d = reinterpret_cast<uchar*>(bytes.data());
+        qToLittleEndian<quint32>(w, d + 8);
+        qToLittleEndian<quint32>(h, d + 12);
+        qToLittleEndian<quint64>(7, d + 24);
+        qToLittleEndian<quint32>(1, d + 32);
+        qToLittleEndian<quint32>(mode, d + 40);
+        std::ofstream out((mzcPath + ".crafted").toStdString(), std::ios::binary);
+        out.write(bytes.constData(), bytes.size());
+        out.write(std::string(payload, '\0').data(), std::streamsize(payload));
+        return out.good();
+    };
+    const quint32 huge = quint32(INT_MAX) - 1;
+    for (auto [w, h, mode, payload] : {std::tuple<quint32, quint32, quint32, size_t>{huge, huge, 1, 0},
+                                       {4096, 4096, 1, 1000}, {huge, huge, 0, 1}}) {
+        if (!craftMzc(w, h, mode, payload) || MazeIO::loadCreate(loaded, cfg2, mzcPath + ".crafted")) {
+            std::cerr << "Crafted .mzc accepted (" << w << "x" << h << ", mode " << mode << ")" << std::endl; return 1;
+        }
+    }
+    // Tiled .mzt: regions match the same window of the maze, across tile
+    // boundaries, in both tile encodings; loadCreate reads the whole maze
+    {
+        QString mztPath = "/mnt/data/maze3d/build/test_maze.mzt";
+        MazeConfig big = cfg; big.width = 150; big.height = 90; big.algorithm = MazeAlgorithm::Eller;
+        MazeGrid maze(big.width, big.height);
+        MazeGenerator::generate(maze, big);
+        const MazeRect regions[] = {{0, 0, 150, 90}, {30, 20, 1, 1}, {60, 60, 70, 29}, {-5, 10, 40, 500}};
+        for (bool compress : {true, false}) {
+            if (!MazeIO::saveTiled(maze, big, mztPath, 64, compress, 3)) { std::cerr << "Tiled save failed" << std::endl; return 1; }
+            for (const MazeRect& r : regions) {
+                if (!MazeIO::readRegion(mztPath, r, loaded, cfg2, 2) || cfg2.width != big.width || cfg2.seed != big.seed) {
+                    std::cerr << "Region read failed" << std::endl; return 1;
+                }
+                const int x0 = std::max(0, r.x), y0 = std::max(0, r.y);
+                if (loaded->width() != std::min(big.width, r.x + r.width) - x0 ||
+                    loaded->height() != std::min(big.height, r.y + r.height) - y0) {
+                    std::cerr << "Region size wrong" << std::endl; return 1;
+                }
+                for (int y=0; y<loaded->height(); ++y)
+                    for (int x=0; x<loaded->width(); ++x)
+                        if (loaded->wallN(x,y) != maze.wallN(x0+x,y0+y) || loaded->wallE(x,y) != maze.wallE(x0+x,y0+y) ||
+                            loaded->wallS(x,y) != maze.wallS(x0+x,y0+y) || loaded->wallW(x,y) != maze.wallW(x0+x,y0+y)) {
+                            std::cerr << "Region wall mismatch at " << x0+x << "," << y0+y << std::endl; return 1;
+                        }
+            }
+        }
+        if (MazeIO::readRegion(mztPath, MazeRect{150, 0, 10, 10}, loaded, cfg2)) { std::cerr << "Empty region read" << std::endl; return 1; }
+        if (!MazeIO::loadCreate(loaded, cfg2, mztPath) || loaded->hWallWords() != maze.hWallWords() ||
+            loaded->vWallWords() != maze.vWallWords()) {
+            std::cerr << "Tiled roundtrip mismatch" << std::endl; return 1;
+        }
+        // Crafted headers: a maze far larger than the file, and a single coded
+        // tile whose payload is too short for its cells
+        auto craftMzt = [&](quint32 size, quint32 tileBytes, qint64 padding) {
+            QFile src(mztPath);
+            QByteArray bytes = src.open(QIODevice::ReadOnly) ? src.read(64) : QByteArray();
+            src.close();
+            uchar* d = reinterpret_cast<uchar*>(bytes.data());
+            for (int at : {8, 12, 36}) qToLittleEndian<quint32>(size, d + at);
+            qToLittleEndian<quint32>(1, d + 40);
+            qToLittleEndian<quint32>(1, d + 44);
+            qToLittleEndian<quint64>(64, d + 48);
+            uchar entry[16];
+            qToLittleEndian<quint64>(80, entry);
+            qToLittleEndian<quint32>(tileBytes, entry + 8);
+            qToLittleEndian<quint32>(1, entry + 12);
+            std::ofstream out((mztPath + ".crafted").toStdString(), std::ios::binary);
+            out.write(bytes.constData(), bytes.size());
+            out.write(reinterpret_cast<const char*>(entry), 16);
+            out.write(std::string(size_t(padding), '\0').data(), std::streamsize(padding));
+            return out.good();
+        };
+        if (!craftMzt(quint32(INT_MAX) - 1, 16, 16) || MazeIO::loadCreate(loaded, cfg2, mztPath + ".crafted") ||
+            !craftMzt(4096, 6, 70000) || MazeIO::loadCreate(loaded, cfg2, mztPath + ".crafted")) {
+            std::cerr << "Crafted .mzt accepted" << std::endl; return 1;
+        }
+    }
+
+    // Progress reaches the full size; canceling fails the call and leaves no file
+    {
+        MazeIO::Progress last;
+        auto track = [&](const MazeIO::Progress& p) { last = p; return true; };
+        if (!MazeIO::saveToJson(grid, cfg, path, MazeIO::JsonEncoding::Cells, track) ||
+            last.cells != last.totalCells || last.totalCells != qint64(grid.width()) * grid.height() ||
+            last.bytes != QFile(path).size()) {
+            std::cerr << "Save progress wrong" << std::endl; return 1;
+        }
+        if (!MazeIO::loadCreate(loaded, cfg2, path, track) || last.bytes != last.totalBytes ||
+            last.cells != last.totalCells || last.totalCells != qint64(grid.width()) * grid.height()) {
+            std::cerr << "Load progress wrong" << std::endl; return 1;
+        }
+        auto cancel = [](const MazeIO::Progress&) { return false; };
+        if (MazeIO::loadCreate(loaded, cfg2, path, cancel)) { std::cerr << "Canceled load succeeded" << std::endl; return 1; }
+        for (const QString& p : {path, binPath, mzcPath})
+            if (MazeIO::save(grid, cfg, p, cancel) || QFile::exists(p)) {
+                std::cerr << "Canceled save left " << p.toStdString() << std::endl; return 1;
+            }
+    }
+
+    // Background jobs: a saved snapshot loads back; a job canceled before it
+    // starts does nothing and reports failure
+    {
+        std::unique_ptr<MazeIOJob> saveJob(MazeIOJob::save(grid, cfg, binPath));
+        saveJob->start();
+        if (!saveJob->wait()) { std::cerr << "Async save failed" << std::endl; return 1; }
+        std::unique_ptr<MazeIOJob> loadJob(MazeIOJob::load(binPath));
+        loadJob->start();
+        if (!loadJob->wait()) { std::cerr << "Async load failed" << std::endl; return 1; }
+        std::unique_ptr<MazeGrid> g = loadJob->takeGrid();
+        if (!g || g->hWallWords() != grid.hWallWords() || g->vWallWords() != grid.vWallWords() ||
+            loadJob->config().seed != cfg.seed) {
+            std::cerr << "Async roundtrip mismatch" << std::endl; return 1;
+        }
+        std::unique_ptr<MazeIOJob> canceled(MazeIOJob::load(binPath));
+        canceled->cancel();
+        canceled->start();
+        if (canceled->wait() || canceled->takeGrid()) { std::cerr << "Canceled job succeeded" << std::endl; return 1; }
+        // A header sizing the maze beyond memory fails the job
+        const QString hugePath = "/mnt/data/maze3d/build/test_huge.json";
+        std::ofstream(hugePath.toStdString()) << R"({"width": 2147483647, "height": 2147483647, "cellMasks": []})";
+        std::unique_ptr<MazeIOJob> huge(MazeIOJob::load(hugePath));
+        huge->start();
+        if (huge->wait() || huge->takeGrid()) { std::cerr << "Job loaded a huge header" << std::endl; return 1; }
+    }
+    // Top-down raster: walls and path land on the expected pixels, threading
+    // doesn't change the image, and the streamed PNG is well formed
+    {
+        MazeRaster::Style style; style.cellPixels = 5; style.wallPixels = 1;
+        const auto solved = MazeSolver::solveBFS(grid, {0,0}, {grid.width()-1, grid.height()-1});
+        const MazeRaster::PathCells cells(solved->nodes, grid.width());
+        const int64_t w = MazeRaster::imageWidth(grid, style), h = MazeRaster::imageHeight(grid, style);
+        if (w != grid.width()*5 + 1 || h != grid.height()*5 + 1) { std::cerr << "Raster size wrong" << std::endl; return 1; }
+        std::vector<uint8_t> one(size_t(w*h)), many(size_t(w*h));
+        MazeRaster::render(grid, cells, style, one.data(), size_t(w), 1);
+        MazeRaster::render(grid, cells, style, many.data(), size_t(w), 3);
+        if (one != many) { std::cerr << "Threaded raster differs" << std::endl; return 1; }
+        auto px = [&](int x, int y){ return one[size_t(y)*size_t(w) + size_t(x)]; };
+        for (int y=0; y<grid.height(); ++y)
+            for (int x=0; x<grid.width(); ++x) {
+                if ((px(x*5+2, y*5) == MazeRaster::Wall) != grid.wallN(x,y) ||
+                    (px(x*5, y*5+2) == MazeRaster::Wall) != grid.wallW(x,y)) {
+                    std::cerr << "Raster wall mismatch at " << x << "," << y << std::endl; return 1;
+                }
+            }
+        for (const Coord& c : solved->nodes)
+            if (px(c.x*5+2, c.y*5+2) != MazeRaster::Path) { std::cerr << "Raster path missing" << std::endl; return 1; }
+
+        // More threads than the strip height must still work
+        const QString pngPath = "/mnt/data/maze3d/build/test_maze.png";
+        for (int threads : {2, 5000}) {
+            if (!MazeRaster::savePNG(grid, cells, style, pngPath, threads)) { std::cerr << "PNG save failed" << std::endl; return 1; }
+            QFile f(pngPath);
+            const QByteArray head = f.open(QIODevice::ReadOnly) ? f.read(8) : QByteArray();
+            if (head != QByteArray("\x89PNG\r\n\x1a\n", 8) || !f.size() || !f.readAll().endsWith("IEND\xae\x42\x60\x82")) {
+                std::cerr << "PNG malformed with " << threads << " threads" << std::endl; return 1;
+            }
+        }
+    }
+    // Dedup across formats and batch files: the same maze saved twice, its
+    // mirror image (a duplicate only canonically) and a batch member
+    {
+        const QString dir = "/mnt/data/maze3d/build/";
+        MazeConfig mirrorCfg = cfg; mirrorCfg.seed = 0;
+        MazeConfig batchCfg; batchCfg.width=12; batchCfg.height=12; batchCfg.algorithm=MazeAlgorithm::Kruskal;
+        std::ofstream batch((dir + "dedup_batch.bin").toStdString(), std::ios::binary);
+        MazeGenerator::generateBatch(batchCfg, 1, 5, batch, 2);
+        batch.close();
+        batchCfg.seed = 3;
+        MazeGrid member(batchCfg.width, batchCfg.height);
+        MazeGenerator::generate(member, batchCfg);
+        if (!MazeIO::saveBinary(grid, cfg, dir + "dedup_a.mzb") || !MazeIO::saveToJson(grid, cfg, dir + "dedup_b.json") ||
+            !MazeIO::saveCompact(MazeFingerprint::transformed(grid, 1), mirrorCfg, dir + "dedup_c.mzc") ||
+            !MazeIO::saveBinary(member, batchCfg, dir + "dedup_d.mzb")) {
+            std::cerr << "Dedup fixtures failed" << std::endl; return 1;
+        }
+        const QStringList files{dir + "dedup_a.mzb", dir + "dedup_batch.bin", dir + "dedup_b.json",
+                                dir + "dedup_missing.mzb", dir + "dedup_c.mzc", dir + "dedup_d.mzb"};
+        for (bool canonical : {false, true}) {
+            const MazeFingerprint::DedupResult r = MazeFingerprint::findDuplicates(files, canonical, 3);
+            const size_t firstGroup = canonical ? 3 : 2;
+            if (r.mazes != 9 || r.failed != std::vector<int>{3} || r.groups.size() != 2 ||
+                r.groups[0].members.size() != firstGroup || r.groups[0].members[1].file != 2 ||
+                r.groups[1].members.size() != 2 || r.groups[1].members[0].file != 1 ||
+                !r.groups[1].members[0].batch || r.groups[1].members[0].index != 2 || r.groups[1].members[1].file != 5) {
+                std::cerr << "Dedup groups wrong" << (canonical ? " (canonical)" : "") << std::endl; return 1;
+            }
+        }
+    }
     std::cout << "Persistence roundtrip OK" << std::endl;
     return 0;
 }